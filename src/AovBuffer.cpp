@@ -0,0 +1,118 @@
+#include "AovBuffer.h"
+
+
+const unsigned int AovBuffer::noObject_;
+
+
+AovBuffer::AovBuffer(const unsigned int width, const unsigned int height)
+: width_{width}
+, height_{height}
+, samples_(width * height, 0)
+, hits_(width * height, 0)
+, depths_(width * height, 0.0f)
+, normals_(width * height, glm::vec3{0.0f, 0.0f, 0.0f})
+, albedos_(width * height, glm::vec3{0.0f, 0.0f, 0.0f})
+, objects_(width * height, noObject_)
+, direct_(width * height, glm::vec3{0.0f, 0.0f, 0.0f})
+, indirect_(width * height, glm::vec3{0.0f, 0.0f, 0.0f})
+{
+
+}
+
+
+void AovBuffer::add(const unsigned int pixel,
+                    const PathIntegrator::FirstSurface& surface,
+                    const glm::vec3& radiance,
+                    const glm::vec3& direct) {
+  const Object* object = surface.intersection.first;
+  const HitRecord& hit = surface.intersection.second;
+
+  if( object != nullptr ) {
+    hits_[pixel]++;
+    depths_[pixel] += surface.distance;
+    normals_[pixel] += hit.shadingNormal;
+    albedos_[pixel] += object->isLight() ? surface.tint : surface.tint * object->getIntensity() * object->getColor(hit);
+  }
+
+  if( samples_[pixel] == 0 && object != nullptr ) {
+    objects_[pixel] = object->getId();
+  }
+
+  samples_[pixel]++;
+  direct_[pixel] += direct;
+  indirect_[pixel] += radiance - direct;
+}
+
+
+void AovBuffer::write(const std::string& name) const {
+  const unsigned int numberOfPixels = width_ * height_;
+
+  // The depths and sample counts are scaled to the largest one in the image
+  float maxDepth = 0.0f;
+  unsigned int maxSamples = 0;
+  for(unsigned int pixel=0; pixel<numberOfPixels; pixel++) {
+    if( hits_[pixel] > 0 ) {
+      maxDepth = std::max(maxDepth, depths_[pixel] / hits_[pixel]);
+    }
+    maxSamples = std::max(maxSamples, samples_[pixel]);
+  }
+
+  std::vector<glm::vec3> depths(numberOfPixels, glm::vec3{0.0f, 0.0f, 0.0f});
+  std::vector<glm::vec3> normals(numberOfPixels, glm::vec3{0.0f, 0.0f, 0.0f});
+  std::vector<glm::vec3> albedos(numberOfPixels, glm::vec3{0.0f, 0.0f, 0.0f});
+  std::vector<glm::vec3> objects(numberOfPixels, glm::vec3{0.0f, 0.0f, 0.0f});
+  std::vector<glm::vec3> samples(numberOfPixels, glm::vec3{0.0f, 0.0f, 0.0f});
+
+  for(unsigned int pixel=0; pixel<numberOfPixels; pixel++) {
+    if( hits_[pixel] > 0 ) {
+      depths[pixel] = glm::vec3{depths_[pixel] / hits_[pixel] / maxDepth};
+      // Each axis from -1 to 1 maps to the whole range of its channel
+      normals[pixel] = 0.5f * normals_[pixel] / (float)hits_[pixel] + 0.5f;
+      albedos[pixel] = albedos_[pixel] / (float)hits_[pixel];
+    }
+
+    if( objects_[pixel] != noObject_ ) {
+      // A hash of the id gives neighbouring objects unrelated colors
+      unsigned int hash = (objects_[pixel] + 1) * 0x9E3779B1u;
+      hash ^= hash >> 15;
+      hash *= 0x85EBCA77u;
+      hash ^= hash >> 13;
+      objects[pixel] = glm::vec3{(hash & 0xff) / 255.0f, ((hash >> 8) & 0xff) / 255.0f, ((hash >> 16) & 0xff) / 255.0f};
+    }
+
+    if( maxSamples > 0 ) {
+      samples[pixel] = glm::vec3{samples_[pixel] / (float)maxSamples};
+    }
+  }
+
+  writeImage(name + "_depth.png", depths);
+  writeImage(name + "_normal.png", normals);
+  writeImage(name + "_albedo.png", albedos);
+  writeImage(name + "_id.png", objects);
+  writeImage(name + "_samples.png", samples);
+
+  // The light is tone mapped as the image is, so that the two add up to it before tone mapping
+  std::vector<unsigned char> direct(numberOfPixels * 4);
+  std::vector<unsigned char> indirect(numberOfPixels * 4);
+  for(unsigned int pixel=0; pixel<numberOfPixels; pixel++) {
+    const float numberOfSamples = std::max(1u, samples_[pixel]);
+    writePixel(direct, width_, pixel % width_, pixel / width_, direct_[pixel] / numberOfSamples);
+    writePixel(indirect, width_, pixel % width_, pixel / width_, glm::max(indirect_[pixel] / numberOfSamples, glm::vec3{0.0f, 0.0f, 0.0f}));
+  }
+  outputImage(name + "_direct.png", direct, width_, height_);
+  outputImage(name + "_indirect.png", indirect, width_, height_);
+}
+
+
+void AovBuffer::writeImage(const std::string& file, const std::vector<glm::vec3>& colors) const {
+  // Values from 0 to 1 map linearly to the range of the channels
+  std::vector<unsigned char> image(width_ * height_ * 4);
+  for(unsigned int pixel=0; pixel<colors.size(); pixel++) {
+    const glm::vec3 color = glm::clamp(colors[pixel], 0.0f, 1.0f);
+    image[4 * pixel + 0] = static_cast<unsigned char>(color.r * 255.0f + 0.5f);
+    image[4 * pixel + 1] = static_cast<unsigned char>(color.g * 255.0f + 0.5f);
+    image[4 * pixel + 2] = static_cast<unsigned char>(color.b * 255.0f + 0.5f);
+    image[4 * pixel + 3] = 255;
+  }
+  outputImage(file, image, width_, height_);
+}
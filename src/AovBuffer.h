@@ -0,0 +1,76 @@
+#ifndef AOVBUFFER_H
+#define AOVBUFFER_H
+
+#include <vector>
+#include <string>
+#include <utility>
+#include <algorithm>
+
+#include "glm/glm.hpp"
+
+#include "PathIntegrator.h"
+
+#include "objects/Object.h"
+#include "objects/meshes/HitRecord.h"
+
+#include "utils/image.h"
+
+
+// Arbitrary output variables of each pixel, gathered from the first surface and the
+// radiance of every sample as it is rendered: the depth, shading normal, albedo and object
+// of the first surface that is not transparent, the number of samples and the split of the
+// radiance into direct and indirect light. The albedo is tinted by the transparent surfaces
+// in front, lights have an albedo of one. Direct light is the light that surface is, or
+// that its shadow rays gather, seen through the transparent surfaces in front; the rest
+// is indirect. Samples of different pixels may be added from different threads, those
+// of one pixel from one thread at a time.
+class AovBuffer {
+
+public:
+  AovBuffer(const unsigned int width, const unsigned int height);
+
+  // Adds a sample of pixel whose path reached surface and which gathered radiance, 
+  // of which direct is direct light
+  void add(const unsigned int pixel,
+           const PathIntegrator::FirstSurface& surface,
+           const glm::vec3& radiance,
+           const glm::vec3& direct);
+
+  unsigned int getSamples(const unsigned int pixel) const { return samples_[pixel]; }
+
+  // Samples of pixel whose path reached a surface
+  unsigned int getHits(const unsigned int pixel) const { return hits_[pixel]; }
+
+  // Means over the hits of pixel, zero where there are none
+  float getDepth(const unsigned int pixel) const { return hits_[pixel] > 0 ? depths_[pixel] / hits_[pixel] : 0.0f; }
+  glm::vec3 getNormal(const unsigned int pixel) const { return hits_[pixel] > 0 ? normals_[pixel] / (float)hits_[pixel] : glm::vec3{0.0f, 0.0f, 0.0f}; }
+  glm::vec3 getAlbedo(const unsigned int pixel) const { return hits_[pixel] > 0 ? albedos_[pixel] / (float)hits_[pixel] : glm::vec3{0.0f, 0.0f, 0.0f}; }
+
+  // Writes one image per variable, name_depth.png, name_normal.png, name_albedo.png,
+  // name_id.png, name_samples.png, name_direct.png and name_indirect.png
+  void write(const std::string& name) const;
+
+protected:
+
+private:
+  // Object of pixels whose first sample missed
+  static const unsigned int noObject_ = ~0u;
+
+  const unsigned int width_;
+  const unsigned int height_;
+
+  std::vector<unsigned int> samples_;
+  std::vector<unsigned int> hits_;
+  std::vector<float> depths_;
+  std::vector<glm::vec3> normals_;
+  std::vector<glm::vec3> albedos_;
+  std::vector<unsigned int> objects_; // Of the first sample, ids do not average
+  std::vector<glm::vec3> direct_;
+  std::vector<glm::vec3> indirect_;
+
+  void writeImage(const std::string& file, const std::vector<glm::vec3>& colors) const;
+
+};
+
+
+#endif // AOVBUFFER_H
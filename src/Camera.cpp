@@ -47,32 +47,26 @@ unsigned int Camera::getSuperSampling() const {
 }
 
 
-std::vector<Ray*> Camera::getRays() const {
-  std::vector<Ray*> rays;
-  rays.resize(pixelSize_.x * pixelSize_.y * superSampling_);
-
-  for(int y=pixels_.y/2; y>-pixels_.y/2; y--) {
-    for(int x=pixels_.x/2; x>-pixels_.x/2; x--) {
-
-      for(unsigned int s=0; s<superSampling_; s++) {
-
-        const glm::vec3 pixelUpperLeftCorner{position_.x + x * pixelSize_.x,
-                                             position_.y + y * pixelSize_.y,
-                                             position_.z + viewPlaneDistance_};
+Camera::RowBasis Camera::getRowBasis(const unsigned int y) const {
+  // The upper left corner of the first pixel of the row on the view plane
+  const glm::vec3 corner{0.0f, (pixels_.y / 2 - static_cast<int>(y)) * pixelSize_.y, viewPlaneDistance_};
+
+  RowBasis row;
+  row.origin = position_ + corner;
+  row.direction = rotation_ * corner;
+  return row;
+}
 
-        const glm::vec3 rayPosition = pixelUpperLeftCorner - glm::vec3{pixelSize_.x * random0To1(), pixelSize_.y  * random0To1(), 0};
-        const glm::vec3 rayDirection = rotation_ * glm::normalize(rayPosition - position_);
 
-        // std::cout << rayPosition.x << " " << rayPosition.y << " " << rayPosition.z << std::endl;
-        // std::cout << rayDirection.x << " " << rayDirection.y << " " << rayDirection.z << std::endl;
-        // std::string line;
-        // std::getline(std::cin, line);
-        rays.push_back(new Ray{rayPosition, rayDirection});
-      }
+Ray Camera::getRay(const RowBasis& row, const unsigned int x, RandomSequence& sequence) const {
+  const glm::vec2 jitter = sequence.next2D();
+  const float offsetX = (pixels_.x / 2 - static_cast<int>(x) - jitter.x) * pixelSize_.x;
+  const float offsetY = -jitter.y * pixelSize_.y;
 
-    }
-  }
+  // The view plane is axis aligned while the directions are rotated, 
+  // the rotation is applied to the offsets through its columns
+  const glm::vec3 origin = row.origin + glm::vec3{offsetX, offsetY, 0.0f};
+  const glm::vec3 direction = glm::normalize(row.direction + offsetX * rotation_[0] + offsetY * rotation_[1]);
 
-  return rays;
+  return Ray{origin, direction};
 }
-
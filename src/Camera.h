@@ -15,6 +15,12 @@
 class Camera {
 
 public:
+  // What the camera rays through one row of pixels have in common
+  struct RowBasis {
+    glm::vec3 origin;
+    glm::vec3 direction;
+  };
+
   Camera(const glm::ivec2 pixels,
          const glm::vec2 pixelSize,
          const glm::vec3 position, 
@@ -34,7 +40,13 @@ public:
 
   unsigned int getSuperSampling() const;
 
-  std::vector<Ray*> getRays() const;
+  // Precomputes the part of the camera rays shared by row y of the image, counted from the top
+  RowBasis getRowBasis(const unsigned int y) const;
+
+  // Camera ray through a random position within pixel x of the row, counted from the left, 
+  // drawn from the next dimension of sequence. Cheap enough to generate the rays on demand 
+  // while rendering.
+  Ray getRay(const RowBasis& row, const unsigned int x, RandomSequence& sequence) const;
 
 protected:
 
@@ -0,0 +1,238 @@
+#include "Denoiser.h"
+
+
+const unsigned int Denoiser::rowsPerWorkItem_;
+const unsigned int Denoiser::featureSamples_;
+const unsigned int Denoiser::maxTransparentHits_;
+const unsigned int Denoiser::maxIterations_;
+constexpr float Denoiser::albedoOffset_;
+constexpr float Denoiser::normalSigma_;
+constexpr float Denoiser::albedoSigma_;
+constexpr float Denoiser::depthSigma_;
+
+// Taps of the B3 spline along one axis
+static const float kernel[5] = {1.0f / 16.0f, 1.0f / 4.0f, 3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f};
+
+
+Denoiser::Denoiser(const Scene& scene,
+                   const Camera& camera,
+                   ThreadPool& threadPool,
+                   const Sampler& sampler,
+                   const unsigned int iterations,
+                   const float colorSigma)
+: scene_(scene)
+, camera_(camera)
+, threadPool_(threadPool)
+, sampler_(sampler)
+, iterations_{iterations}
+, colorSigma_{colorSigma}
+{
+  if( colorSigma <= 0.0f ) {
+    throw std::invalid_argument{"The color sigma of the denoiser must be above 0"};
+  }
+  if( iterations > maxIterations_ ) {
+    throw std::invalid_argument{"The denoiser takes at most 31 iterations"};
+  }
+}
+
+
+std::vector<glm::vec3> Denoiser::denoise(const std::vector<glm::vec3>& colors, 
+                                         const std::vector<unsigned int>& samples, 
+                                         const AovBuffer* aovs) {
+  if( aovs != nullptr ) {
+    copyFeatures(*aovs);
+  } else {
+    gatherFeatures();
+  }
+
+  std::vector<glm::vec3> current(colors.size());
+  for(unsigned int i=0; i<colors.size(); i++) {
+    current[i] = colors[i] / (features_[i].albedo + albedoOffset_);
+  }
+
+  std::vector<glm::vec3> next(colors.size());
+  std::vector<glm::vec3> display(colors.size());
+
+  // The sigma of a pixel of n samples is colorSigma_ / sqrt(n) 
+  std::vector<float> colorFactors(colors.size());
+  for(unsigned int i=0; i<colors.size(); i++) {
+    colorFactors[i] = std::max(1u, samples[i]) / (colorSigma_ * colorSigma_);
+  }
+
+  for(unsigned int iteration=0; iteration<iterations_; iteration++) {
+    for(unsigned int i=0; i<current.size(); i++) {
+      display[i] = glm::sqrt(current[i]);
+    }
+    filter(current, display, next, 1u << iteration, colorFactors);
+    current.swap(next);
+
+    // Every iteration halves the sigma
+    for(float& colorFactor : colorFactors) {
+      colorFactor *= 4.0f;
+    }
+  }
+
+  for(unsigned int i=0; i<colors.size(); i++) {
+    current[i] *= features_[i].albedo + albedoOffset_;
+  }
+
+  return current;
+}
+
+
+void Denoiser::gatherFeatures() {
+  const unsigned int width = camera_.getPixels().x;
+  const unsigned int height = camera_.getPixels().y;
+
+  features_.resize(width * height);
+
+  forEachBand([this, width](const unsigned int firstRow, const unsigned int endRow) {
+    for(unsigned int y=firstRow; y<endRow; y++) {
+      const Camera::RowBasis row = camera_.getRowBasis(y);
+
+      for(unsigned int x=0; x<width; x++) {
+        Features sum{glm::vec3{0.0f, 0.0f, 0.0f}, glm::vec3{0.0f, 0.0f, 0.0f}, 0.0f};
+
+        // The camera rays of the first samples of the pixel, as the render drew them
+        for(unsigned int s=0; s<featureSamples_; s++) {
+          RandomSequence sequence{&sampler_, y * width + x, s};
+          const Features features = traceFeatures(camera_.getRay(row, x, sequence));
+          sum.albedo += features.albedo;
+          sum.normal += features.normal;
+          sum.depth += features.depth;
+        }
+
+        Features& features = features_[y * width + x];
+        features.albedo = sum.albedo / (float)featureSamples_;
+        features.normal = sum.normal / (float)featureSamples_;
+        features.depth = sum.depth / featureSamples_;
+      }
+    }
+  });
+}
+
+
+void Denoiser::copyFeatures(const AovBuffer& aovs) {
+  features_.resize(camera_.getPixels().x * camera_.getPixels().y);
+
+  for(unsigned int pixel=0; pixel<features_.size(); pixel++) {
+    // Misses have an albedo of one, as the traced features do
+    const unsigned int samples = aovs.getSamples(pixel);
+    const float hits = samples > 0 ? aovs.getHits(pixel) / (float)samples : 0.0f;
+
+    Features& features = features_[pixel];
+    features.albedo = hits * aovs.getAlbedo(pixel) + (1.0f - hits);
+    features.normal = hits * aovs.getNormal(pixel);
+    features.depth = hits * aovs.getDepth(pixel);
+  }
+}
+
+
+Denoiser::Features Denoiser::traceFeatures(const Ray& cameraRay) const {
+  glm::vec3 origin = cameraRay.getOrigin();
+  glm::vec3 direction = cameraRay.getDirection();
+  glm::vec3 tint{1.0f, 1.0f, 1.0f};
+  float distance = 0.0f;
+  float refractionIndex = 1.0f;
+
+  for(unsigned int hits=0; hits<maxTransparentHits_; hits++) {
+    const Ray ray{origin, direction};
+    const std::pair<Object*, HitRecord> intersection = scene_.intersect(&ray);
+    const Object* object = intersection.first;
+    const HitRecord& hit = intersection.second;
+
+    if( object == nullptr ) {
+      return Features{tint, glm::vec3{0.0f, 0.0f, 0.0f}, 0.0f};
+    }
+
+    const bool leaving = glm::dot(direction, hit.normal) > 0.0f;
+    const glm::vec3 normal = leaving ? -hit.shadingNormal : hit.shadingNormal;
+    distance += hit.t;
+
+    if( object->isLight() ) {
+      return Features{tint, normal, distance};
+    }
+
+    if( !object->isTransparent() ) {
+      return Features{tint * object->getIntensity() * object->getColor(hit), normal, distance};
+    }
+
+    // Looks through the surface along whichever of the refraction and the reflection 
+    // carries more of the light, the way the integrator picks between them
+    PathIntegrator::crossTransparent(static_cast<const TransparentObject*>(object), hit, 0.5f, 
+                                     origin, direction, refractionIndex);
+
+    tint *= object->getIntensity();
+  }
+
+  return Features{tint, glm::vec3{0.0f, 0.0f, 0.0f}, 0.0f};
+}
+
+
+void Denoiser::filter(const std::vector<glm::vec3>& input,
+                      const std::vector<glm::vec3>& display,
+                      std::vector<glm::vec3>& output,
+                      const unsigned int step,
+                      const std::vector<float>& colorFactors) {
+  const int width = camera_.getPixels().x;
+  const int height = camera_.getPixels().y;
+
+  const float normalFactor = 1.0f / (normalSigma_ * normalSigma_);
+  const float albedoFactor = 1.0f / (albedoSigma_ * albedoSigma_);
+
+  forEachBand([&](const unsigned int firstRow, const unsigned int endRow) {
+    for(int y=firstRow; y<(int)endRow; y++) {
+      for(int x=0; x<width; x++) {
+        const unsigned int p = y * width + x;
+        const Features& center = features_[p];
+        const glm::vec3 centerColor = display[p];
+        const float colorFactor = colorFactors[p];
+        const float depthFactor = 1.0f / std::max(1e-6f, depthSigma_ * depthSigma_ * center.depth * center.depth);
+
+        glm::vec3 sum{0.0f, 0.0f, 0.0f};
+        float weights = 0.0f;
+
+        for(int j=0; j<5; j++) {
+          const int ty = y + (j - 2) * (int)step;
+          if( ty < 0 || ty >= height ) {
+            continue;
+          }
+
+          for(int i=0; i<5; i++) {
+            const int tx = x + (i - 2) * (int)step;
+            if( tx < 0 || tx >= width ) {
+              continue;
+            }
+
+            const unsigned int q = ty * width + tx;
+            const Features& tap = features_[q];
+
+            const glm::vec3 colorDifference = display[q] - centerColor;
+            const glm::vec3 normalDifference = tap.normal - center.normal;
+            const glm::vec3 albedoDifference = tap.albedo - center.albedo;
+            const float depthDifference = tap.depth - center.depth;
+
+            const float exponent = glm::dot(colorDifference, colorDifference) * colorFactor +
+                                   glm::dot(normalDifference, normalDifference) * normalFactor +
+                                   glm::dot(albedoDifference, albedoDifference) * albedoFactor +
+                                   depthDifference * depthDifference * depthFactor;
+
+            const float weight = kernel[i] * kernel[j] * std::exp(-exponent);
+            sum += input[q] * weight;
+            weights += weight;
+          }
+        }
+
+        // The center tap always counts, its exponent is 0
+        output[p] = sum / weights;
+      }
+    }
+  });
+}
+
+
+void Denoiser::forEachBand(const std::function<void(const unsigned int firstRow, const unsigned int endRow)>& work) {
+  threadPool_.parallelFor(0, camera_.getPixels().y, rowsPerWorkItem_, [&work](const unsigned int, const unsigned int firstRow, const unsigned int rows) {
+    work(firstRow, firstRow + rows);
+  });
+}
@@ -0,0 +1,120 @@
+#ifndef DENOISER_H
+#define DENOISER_H
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+
+#include "glm/glm.hpp"
+
+#include "AovBuffer.h"
+#include "Camera.h"
+#include "PathIntegrator.h"
+#include "Ray.h"
+#include "Scene.h"
+
+#include "objects/Object.h"
+#include "objects/TransparentObject.h"
+#include "objects/meshes/HitRecord.h"
+
+#include "thread/ThreadPool.h"
+#include "thread/WorkItem.h"
+
+#include "samplers/Sampler.h"
+
+#include "utils/math.h"
+#include "utils/random.h"
+#include "utils/RandomSequence.h"
+
+
+// Edge-avoiding a-trous wavelet filter of Dammertz et al., "Edge-Avoiding A-Trous Wavelet
+// Transform for fast Global Illumination Filtering", run on a rendered image. Each iteration
+// blurs with a 5x5 B3 spline whose taps are twice as far apart as in the one before, and
+// weighs every tap down by how much its color and the albedo, normal and depth at its first
+// hit differ from those of the pixel. The albedo is divided out before filtering and
+// multiplied back after, so that texture is kept and only the lighting is smoothed.
+class Denoiser {
+
+public:
+  // What the camera rays of a pixel see first, averaged over featureSamples_ rays or
+  // over the samples of the AOVs. Transparent surfaces are looked through, lights and 
+  // misses have an albedo of one.
+  struct Features {
+    glm::vec3 albedo;
+    glm::vec3 normal;
+    float depth;
+  };
+
+  // colorSigma is the color difference, in the square root space the image is written
+  // in, at which the first iteration weighs a tap down by 1/e in a pixel of one sample.
+  // It shrinks with the square root of the samples of each pixel, as the noise does.
+  // Taps of more than 31 iterations would be further apart than any image is wide.
+  Denoiser(const Scene& scene,
+           const Camera& camera,
+           ThreadPool& threadPool,
+           const Sampler& sampler,
+           const unsigned int iterations,
+           const float colorSigma);
+
+  // Filtered radiance of each pixel, row by row from the top left as colors, 
+  // samples holds the number of samples of each pixel in the same order. The features 
+  // come from the first surfaces aovs gathered during the render when given, instead 
+  // of from camera rays of their own. Behind a transparent surface those mix the 
+  // reflection and the refraction as the paths do, the rays follow the larger one.
+  std::vector<glm::vec3> denoise(const std::vector<glm::vec3>& colors, 
+                                 const std::vector<unsigned int>& samples, 
+                                 const AovBuffer* aovs = nullptr);
+
+  // Features of the last call to denoise()
+  const std::vector<Features>& getFeatures() const { return features_; }
+
+protected:
+
+private:
+  static const unsigned int rowsPerWorkItem_ = 8;
+  static const unsigned int featureSamples_ = 4;
+  static const unsigned int maxTransparentHits_ = 8;
+  static const unsigned int maxIterations_ = 31;
+
+  // Keeps the albedo of black surfaces from dividing by zero
+  static constexpr float albedoOffset_ = 0.01f;
+
+  static constexpr float normalSigma_ = 0.3f;
+  static constexpr float albedoSigma_ = 0.1f;
+
+  // Relative to the depth of the pixel
+  static constexpr float depthSigma_ = 0.05f;
+
+  const Scene& scene_;
+  const Camera& camera_;
+  ThreadPool& threadPool_;
+  const Sampler& sampler_;
+  const unsigned int iterations_;
+  const float colorSigma_;
+
+  std::vector<Features> features_;
+
+  void gatherFeatures();
+
+  void copyFeatures(const AovBuffer& aovs);
+
+  Features traceFeatures(const Ray& cameraRay) const;
+
+  // One iteration with taps step pixels apart from input into output, display holds 
+  // the square roots of input and colorFactors 1 / colorSigma^2 of each pixel
+  void filter(const std::vector<glm::vec3>& input,
+              const std::vector<glm::vec3>& display,
+              std::vector<glm::vec3>& output,
+              const unsigned int step,
+              const std::vector<float>& colorFactors);
+
+  // Runs work on every band of rowsPerWorkItem_ rows on the pool and waits for them all
+  void forEachBand(const std::function<void(const unsigned int firstRow, const unsigned int endRow)>& work);
+
+};
+
+
+#endif // DENOISER_H
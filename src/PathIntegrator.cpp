@@ -0,0 +1,201 @@
+#include "PathIntegrator.h"
+
+
+PathIntegrator::PathIntegrator(const Scene& scene, const unsigned int numberOfShadowRays, const unsigned int minimumDepth, const unsigned int maximumDepth)
+: scene_(scene)
+, numberOfShadowRays_{numberOfShadowRays}
+, minimumDepth_{minimumDepth}
+, maximumDepth_{maximumDepth}
+, dimensionsPerBounce_{2 + 2 * numberOfShadowRays}
+{
+  if( maximumDepth_ == 0 ) {
+    throw std::invalid_argument{"PathIntegrator needs a maximum depth of at least 1."};
+  }
+}
+
+
+glm::vec3 PathIntegrator::trace(const Ray* cameraRay, 
+                                const std::pair<Object*, HitRecord>& cameraIntersection, 
+                                RandomSequence& sequence, 
+                                glm::vec3* direct, 
+                                FirstSurface* surface) const {
+  glm::vec3 radiance{0.0f, 0.0f, 0.0f};
+
+  if( surface != nullptr ) {
+    *surface = FirstSurface{cameraIntersection};
+  }
+  if( direct != nullptr ) {
+    *direct = radiance;
+  }
+
+  PathState path = begin(cameraRay);
+  ShadowConnection shadow;
+
+  std::pair<Object*, HitRecord> intersection = cameraIntersection;
+  bool pastFirstSurface = false;
+
+  while( true ) {
+    const bool transparent = intersection.first != nullptr && intersection.first->isTransparent();
+    const bool continues = scatter(path, intersection, radiance, shadow, sequence);
+
+    if( shadow.object != nullptr ) {
+      radiance += connect(shadow, sequence);
+    }
+
+    // Transparent surfaces add no light, everything up to here came from the first 
+    // surface that is not transparent
+    if( direct != nullptr && !transparent && !pastFirstSurface ) {
+      *direct = radiance;
+    }
+    pastFirstSurface = pastFirstSurface || !transparent;
+
+    if( !continues ) {
+      break;
+    }
+
+    const Ray ray{path.origin, path.direction};
+    intersection = scene_.intersect(&ray);
+
+    if( surface != nullptr ) {
+      surface->follow(intersection);
+    }
+  }
+
+  return radiance;
+}
+
+
+PathIntegrator::PathState PathIntegrator::begin(const Ray* cameraRay) const {
+  PathState path;
+  path.origin = cameraRay->getOrigin();
+  path.direction = cameraRay->getDirection();
+  path.throughput = glm::vec3{1.0f, 1.0f, 1.0f};
+  path.refractionIndex = 1.0f;
+  path.depth = 0;
+  return path;
+}
+
+
+bool PathIntegrator::scatter(PathState& path, const std::pair<Object*, HitRecord>& intersection, glm::vec3& radiance, ShadowConnection& shadow, RandomSequence& sequence) const {
+  Object* object = intersection.first;
+  const HitRecord& hit = intersection.second;
+
+  shadow.object = nullptr;
+
+  if( object == nullptr ) { // No intersection found
+    return false;
+  }
+
+  if( object->isLight() ) {
+    radiance += path.throughput * object->getIntensity();
+    return false;
+  }
+
+  const glm::vec3 direction = path.direction;
+
+  // The bounce draws its direction, then the roulette and then the shadow rays, 
+  // from the same dimensions in every sample
+  const unsigned int dimension = cameraDimensions_ + path.depth * dimensionsPerBounce_;
+  sequence.setDimension(dimension);
+
+  if( object->isTransparent() ) {
+
+    // Picking reflection or refraction with the probability of its share keeps the throughput
+    crossTransparent(static_cast<const TransparentObject*>(object), hit, sequence.next0To1(), 
+                     path.origin, path.direction, path.refractionIndex);
+
+    path.throughput *= object->getIntensity();
+
+  } else { // Opaque and not a light source
+
+    const glm::vec3 normal = hit.shadingNormal;
+    const Frame frame{normal};
+
+    // Both directions point away from the surface, the outgoing one is cosine weighted
+    const glm::vec3 incoming = frame.toLocal(-direction);
+    const glm::vec3 outgoing = getRandomVector(sequence.next2D());
+
+    const float brdf = static_cast<const OpaqueObject*>(object)->computeBrdf(hit.position, incoming, outgoing);
+
+    const glm::vec3 color = object->getIntensity() * object->getColor(hit);
+
+    path.origin = hit.position + (normal - direction) * getEpsilon();
+
+    shadow.origin = path.origin;
+    shadow.normal = normal;
+    shadow.incoming = incoming;
+    shadow.weight = path.throughput * color * 10.0f;
+    shadow.object = object;
+    shadow.dimension = dimension + 2;
+
+    // The brdf times the cosine over the probability density of the cosine weighted direction
+    path.throughput *= color * (0.5f * brdf * (float)M_PI);
+
+    path.direction = frame.toWorld(outgoing);
+  }
+
+  // Past the minimum depth the path survives with the probability of its largest throughput 
+  // component, paths that carry little light end early and the survivors make up for them. 
+  // Its number has a dimension of its own, so it does not follow the bounce direction.
+  if( ++path.depth >= minimumDepth_ ) {
+    sequence.setDimension(dimension + 1);
+
+    const float survival = std::min(1.0f, std::max(path.throughput.r, std::max(path.throughput.g, path.throughput.b)));
+
+    if( survival <= 0.0f || sequence.next0To1() > survival ) {
+      return false;
+    }
+
+    path.throughput /= survival;
+  }
+
+  return path.depth < maximumDepth_;
+}
+
+
+glm::vec3 PathIntegrator::connect(const ShadowConnection& shadow, RandomSequence& sequence) const {
+  sequence.setDimension(shadow.dimension);
+
+  return shadow.weight * scene_.castShadowRays(shadow.origin,
+                                               shadow.incoming,
+                                               shadow.object,
+                                               numberOfShadowRays_,
+                                               shadow.normal,
+                                               sequence);
+}
+
+
+void PathIntegrator::crossTransparent(const TransparentObject* material, 
+                                      const HitRecord& hit, 
+                                      const float choice, 
+                                      glm::vec3& origin, 
+                                      glm::vec3& direction, 
+                                      float& refractionIndex) {
+  // The geometric normal tells whether the ray enters or leaves the object, 
+  // the shading normal is turned towards the side the ray comes from
+  const bool leaving = glm::dot(direction, hit.normal) > 0.0f;
+  const glm::vec3 normal = leaving ? -hit.shadingNormal : hit.shadingNormal;
+
+  float n1 = refractionIndex;
+  float n2 = material->getRefractionIndex();
+
+  if( leaving ) {
+    n1 = material->getRefractionIndex();
+    n2 = 1.0f; // Air
+  }
+
+  // The transparent share of the surface splits between reflection and refraction by the 
+  // Fresnel equations, the rest is a mirror. Under total internal reflection nothing refracts.
+  const float cosIncident = std::min(1.0f, std::abs(glm::dot(direction, normal)));
+  const float reflectance = fresnelDielectric(cosIncident, n1 / n2);
+  const float refraction = material->getTransparancy() * (1.0f - reflectance);
+
+  if( choice < refraction ) {
+    origin = hit.position + (direction - normal) * getEpsilon();
+    direction = glm::normalize(glm::refract(direction, normal, n1 / n2));
+    refractionIndex = n2;
+  } else {
+    origin = hit.position + (normal - direction) * getEpsilon();
+    direction = glm::reflect(direction, normal);
+  }
+}
@@ -0,0 +1,127 @@
+#ifndef PATHINTEGRATOR_H
+#define PATHINTEGRATOR_H
+
+#include <utility>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+#include "glm/glm.hpp"
+
+#include "Ray.h"
+#include "Scene.h"
+
+#include "objects/Object.h"
+#include "objects/OpaqueObject.h"
+#include "objects/TransparentObject.h"
+#include "objects/meshes/HitRecord.h"
+
+#include "utils/random.h"
+
+
+// Follows a camera path one bounce at a time, keeping the throughput of the
+// path and the radiance gathered so far instead of a tree of nodes. Transparent
+// surfaces continue along either the reflection or the refraction with the
+// probability of their Fresnel share, which has the same expectation as following both.
+class PathIntegrator {
+
+public:
+  // A path between two bounces, origin and direction give the ray to extend it with
+  struct PathState {
+    glm::vec3 origin;
+    glm::vec3 direction;
+    glm::vec3 throughput;
+    float refractionIndex;
+    unsigned int depth;
+  };
+
+  // Direct light to gather at an opaque bounce, weight is the throughput up to the bounce. 
+  // Connections with a null object gather nothing.
+  struct ShadowConnection {
+    glm::vec3 origin;
+    glm::vec3 normal;
+    glm::vec3 incoming; // Towards where the path came from, in the shading frame of normal
+    glm::vec3 weight;
+    Object* object;
+    unsigned int dimension; // First dimension of the random numbers of the shadow rays
+  };
+
+  // The first surface along a camera path that is not transparent, what the AOVs and the 
+  // denoiser see of a sample. The path is followed through the transparent surfaces before 
+  // it, which tint it by their intensity. Stays at the last transparent one when the path 
+  // ends on it, the object is null for a miss.
+  struct FirstSurface {
+    std::pair<Object*, HitRecord> intersection;
+    float distance;
+    glm::vec3 tint;
+
+    explicit FirstSurface(const std::pair<Object*, HitRecord>& cameraIntersection = std::pair<Object*, HitRecord>{nullptr, HitRecord{}})
+    : intersection(cameraIntersection)
+    , distance{cameraIntersection.second.t}
+    , tint{1.0f, 1.0f, 1.0f} {}
+
+    // Moves on to the next intersection of the path while the surface is transparent
+    void follow(const std::pair<Object*, HitRecord>& next) {
+      if( intersection.first != nullptr && intersection.first->isTransparent() ) {
+        tint *= intersection.first->getIntensity();
+        intersection = next;
+        distance += next.second.t;
+      }
+    }
+  };
+
+  // Russian roulette starts once a path has bounced minimumDepth times, 
+  // no path bounces more than maximumDepth times
+  PathIntegrator(const Scene& scene, const unsigned int numberOfShadowRays, const unsigned int minimumDepth, const unsigned int maximumDepth);
+
+  // Radiance arriving along ray, whose nearest intersection has already been found, with 
+  // the random numbers of the path drawn from sequence. Surface, when given, receives the 
+  // first surface of the path and direct the part of the radiance that is the light hit 
+  // there and the light its shadow rays gather, through the transparent surfaces in front.
+  glm::vec3 trace(const Ray* ray, 
+                  const std::pair<Object*, HitRecord>& intersection, 
+                  RandomSequence& sequence, 
+                  glm::vec3* direct = nullptr, 
+                  FirstSurface* surface = nullptr) const;
+
+  glm::vec3 trace(const Ray* ray, RandomSequence& sequence) const { return trace(ray, scene_.intersect(ray), sequence); }
+
+  // The steps of trace() for integrators that schedule them differently. A path starts 
+  // at a camera ray. scatter() bounces it at the intersection of its ray, adds light it 
+  // hits to radiance, fills in the shadow connection to gather and returns whether the 
+  // path continues along its new ray. connect() gathers the light of a shadow connection. 
+  // Both draw from the sequence of the path.
+  PathState begin(const Ray* cameraRay) const;
+
+  bool scatter(PathState& path, const std::pair<Object*, HitRecord>& intersection, glm::vec3& radiance, ShadowConnection& shadow, RandomSequence& sequence) const;
+
+  glm::vec3 connect(const ShadowConnection& shadow, RandomSequence& sequence) const;
+
+  // Continues a ray that hits a transparent surface along direction from a medium of 
+  // refractionIndex. It refracts when choice, in [0, 1), is below the share of the light 
+  // that does and reflects otherwise. Origin, direction and refractionIndex are those to 
+  // continue with.
+  static void crossTransparent(const TransparentObject* material, 
+                               const HitRecord& hit, 
+                               const float choice, 
+                               glm::vec3& origin, 
+                               glm::vec3& direction, 
+                               float& refractionIndex);
+
+protected:
+
+private:
+  const Scene& scene_;
+  const unsigned int numberOfShadowRays_;
+  const unsigned int minimumDepth_;
+  const unsigned int maximumDepth_;
+
+  // The camera ray takes the first dimension of the sampler, each bounce then takes 
+  // one for its direction, one for the roulette and two per shadow ray
+  static const unsigned int cameraDimensions_ = 1;
+  const unsigned int dimensionsPerBounce_;
+
+};
+
+
+#endif // PATHINTEGRATOR_H
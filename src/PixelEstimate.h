@@ -0,0 +1,70 @@
+#ifndef PIXELESTIMATE_H
+#define PIXELESTIMATE_H
+
+#include <cmath>
+#include <algorithm>
+
+#include "glm/glm.hpp"
+
+
+// Running mean of the samples of one pixel and the variance of their luminance, 
+// updated one sample at a time with Welford's algorithm.
+class PixelEstimate {
+
+public:
+  PixelEstimate()
+  : numberOfSamples_{0}
+  , mean_{0.0f, 0.0f, 0.0f}
+  , luminanceMean_{0.0f}
+  , luminanceSquaredDeviations_{0.0f}
+  {
+
+  }
+
+  void add(const glm::vec3& sample) {
+    numberOfSamples_++;
+    mean_ += (sample - mean_) / (float)numberOfSamples_;
+
+    const float luminance = (sample.r + sample.g + sample.b) / 3.0f;
+    const float deviation = luminance - luminanceMean_;
+    luminanceMean_ += deviation / numberOfSamples_;
+    luminanceSquaredDeviations_ += deviation * (luminance - luminanceMean_);
+  }
+
+  unsigned int getNumberOfSamples() const { return numberOfSamples_; }
+
+  glm::vec3 getMean() const { return mean_; }
+
+  float getVariance() const { return numberOfSamples_ > 1 ? luminanceSquaredDeviations_ / (numberOfSamples_ - 1) : 0.0f; }
+
+  // True once the 95% confidence interval of the mean luminance, written out as writePixel() 
+  // does, is within threshold output levels of it. The variance of a single pixel is easily 
+  // underestimated before it has seen its rare bright paths, pass the variance pooled over 
+  // its neighbours instead.
+  bool isConverged(const float threshold, const float variance) const {
+    if( numberOfSamples_ < 2 ) {
+      return false;
+    }
+    // The derivative of the square root carries the interval of the mean over
+    const float halfWidth = 1.96f * std::sqrt(variance / numberOfSamples_);
+    const float luminance = luminanceMean_ > minimumLuminance_ ? luminanceMean_ : minimumLuminance_;
+    return outputScale_ * halfWidth / (2.0f * std::sqrt(luminance)) <= threshold;
+  }
+
+protected:
+
+private:
+  static constexpr float minimumLuminance_ = 0.01f;
+
+  // Output levels per unit of the square root of the radiance, as in writePixel()
+  static constexpr float outputScale_ = 100.0f;
+
+  unsigned int numberOfSamples_;
+  glm::vec3 mean_;
+  float luminanceMean_;
+  float luminanceSquaredDeviations_;
+
+};
+
+
+#endif // PIXELESTIMATE_H
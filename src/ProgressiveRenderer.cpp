@@ -0,0 +1,209 @@
+#include "ProgressiveRenderer.h"
+
+
+const unsigned int ProgressiveRenderer::tileSize_;
+
+
+ProgressiveRenderer::ProgressiveRenderer(const Scene& scene,
+                                         const PathIntegrator& integrator,
+                                         const Camera& camera,
+                                         ThreadPool& threadPool,
+                                         const bool packetTracing,
+                                         const Sampler& sampler)
+: scene_(scene)
+, integrator_(integrator)
+, camera_(camera)
+, threadPool_(threadPool)
+, packetTracing_{packetTracing}
+, sampler_(sampler)
+, passes_{0}
+, stopped_{false}
+, maxPasses_{0}
+, timeBudget_{0.0}
+, outputInterval_{0.0}
+, aovs_{nullptr}
+{
+
+}
+
+
+std::vector<glm::vec3> ProgressiveRenderer::render(const unsigned int maxPasses,
+                                                   const double timeBudget,
+                                                   const double outputInterval,
+                                                   Output output,
+                                                   AovBuffer* aovs) {
+  const glm::ivec2 pixels = camera_.getPixels();
+  const unsigned int width = pixels.x;
+  const unsigned int height = pixels.y;
+  const unsigned int tilesX = (width + tileSize_ - 1) / tileSize_;
+  const unsigned int tilesY = (height + tileSize_ - 1) / tileSize_;
+  const unsigned int numberOfTiles = tilesX * tilesY;
+
+  sums_.assign(width * height, glm::vec3{0.0f, 0.0f, 0.0f});
+  tilePasses_.assign(numberOfTiles, 0);
+
+  passes_ = std::min(maxPasses, 1u);
+  stopped_ = false;
+  maxPasses_ = maxPasses;
+  timeBudget_ = timeBudget;
+  outputInterval_ = outputInterval;
+  output_ = output;
+  aovs_ = aovs;
+
+  startTime_ = Clock::now();
+  lastOutputTime_ = startTime_;
+
+  if( passes_ == 0 ) {
+    return sums_;
+  }
+
+  for(unsigned int tile=0; tile<numberOfTiles; tile++) {
+    queue(tile, 0);
+  }
+
+  threadPool_.wait();
+
+  std::lock_guard<std::mutex> guardian(lock_);
+  return getColors();
+}
+
+
+void ProgressiveRenderer::queue(const unsigned int tile, const unsigned int pass) {
+  threadPool_.add(new WorkItem([this, tile, pass]() {
+    renderTile(tile, pass);
+
+    bool next = false;
+    std::vector<glm::vec3> colors;
+
+    lock_.lock();
+    next = continues(pass);
+    if( output_ && outputInterval_ > 0.0 && getSeconds(lastOutputTime_) >= outputInterval_ ) {
+      lastOutputTime_ = Clock::now();
+      colors = getColors();
+    }
+    lock_.unlock();
+
+    // Outside the lock, the other tiles keep rendering while the image is written
+    if( !colors.empty() ) {
+      std::lock_guard<std::mutex> guardian(outputLock_);
+      output_(colors);
+    }
+
+    if( next ) {
+      queue(tile, pass + 1);
+    }
+  }, pass));
+}
+
+
+void ProgressiveRenderer::renderTile(const unsigned int tile, const unsigned int pass) {
+  const glm::ivec2 pixels = camera_.getPixels();
+  const unsigned int width = pixels.x;
+  const unsigned int height = pixels.y;
+  const unsigned int tilesX = (width + tileSize_ - 1) / tileSize_;
+
+  const unsigned int tileX = (tile % tilesX) * tileSize_;
+  const unsigned int tileY = (tile / tilesX) * tileSize_;
+  const unsigned int tileWidth = std::min(tileSize_, width - tileX);
+  const unsigned int tileHeight = std::min(tileSize_, height - tileY);
+  const unsigned int numberOfPixels = tileWidth * tileHeight;
+
+  // The pass is the sample of the pixels, the same path as in the other modes
+  RandomSequence sequences[RayPacket::maxSize];
+
+  std::vector<Ray> cameraRays;
+  cameraRays.reserve(numberOfPixels);
+  for(unsigned int y=0; y<tileHeight; y++) {
+    const Camera::RowBasis rowBasis = camera_.getRowBasis(tileY + y);
+    for(unsigned int x=tileX; x<tileX + tileWidth; x++) {
+      RandomSequence& sequence = sequences[cameraRays.size()];
+      sequence = RandomSequence{&sampler_, (tileY + y) * width + x, pass};
+      cameraRays.push_back(camera_.getRay(rowBasis, x, sequence));
+    }
+  }
+
+  RayPacket packet;
+  for(unsigned int i=0; i<numberOfPixels; i++) {
+    packet.add(&cameraRays[i]);
+  }
+  packet.complete();
+
+  std::pair<Object*, HitRecord> intersections[RayPacket::maxSize];
+
+  if( packetTracing_ ) {
+    scene_.intersect(packet, intersections);
+  } else {
+    for(unsigned int i=0; i<numberOfPixels; i++) {
+      intersections[i] = scene_.intersect(packet.getRay(i));
+    }
+  }
+
+  glm::vec3 radiance[RayPacket::maxSize];
+  glm::vec3 direct[RayPacket::maxSize];
+  PathIntegrator::FirstSurface surfaces[RayPacket::maxSize];
+  for(unsigned int i=0; i<numberOfPixels; i++) {
+    radiance[i] = integrator_.trace(packet.getRay(i), intersections[i], sequences[i], 
+                                    aovs_ != nullptr ? &direct[i] : nullptr, 
+                                    aovs_ != nullptr ? &surfaces[i] : nullptr);
+  }
+
+  // Only this tile writes its pixels, the lock keeps them consistent with its passes
+  std::lock_guard<std::mutex> guardian(lock_);
+  for(unsigned int i=0; i<numberOfPixels; i++) {
+    const unsigned int pixel = (tileY + i / tileWidth) * width + tileX + i % tileWidth;
+    sums_[pixel] += radiance[i];
+    if( aovs_ != nullptr ) {
+      aovs_->add(pixel, surfaces[i], radiance[i], direct[i]);
+    }
+  }
+  tilePasses_[tile]++;
+}
+
+
+bool ProgressiveRenderer::continues(const unsigned int pass) {
+  if( pass + 1 < passes_ ) {
+    return true;
+  }
+
+  if( stopped_ ) {
+    return false;
+  }
+
+  // The first tile to finish the last pass decides for all of them. The pass after
+  // it is expected to take as long as the passes so far did on average.
+  const double seconds = getSeconds(startTime_);
+  const double passSeconds = seconds / (pass + 1);
+
+  if( passes_ < maxPasses_ && (timeBudget_ <= 0.0 || seconds + passSeconds <= timeBudget_) ) {
+    passes_++;
+    return true;
+  }
+
+  stopped_ = true;
+  return false;
+}
+
+
+std::vector<glm::vec3> ProgressiveRenderer::getColors() const {
+  const glm::ivec2 pixels = camera_.getPixels();
+  const unsigned int width = pixels.x;
+  const unsigned int tilesX = (width + tileSize_ - 1) / tileSize_;
+
+  std::vector<glm::vec3> colors(sums_.size(), glm::vec3{0.0f, 0.0f, 0.0f});
+
+  for(unsigned int pixel=0; pixel<sums_.size(); pixel++) {
+    const unsigned int x = pixel % width;
+    const unsigned int y = pixel / width;
+    const unsigned int tilePasses = tilePasses_[(y / tileSize_) * tilesX + x / tileSize_];
+    if( tilePasses > 0 ) {
+      colors[pixel] = sums_[pixel] / (float)tilePasses;
+    }
+  }
+
+  return colors;
+}
+
+
+double ProgressiveRenderer::getSeconds(const Clock::time_point& time) const {
+  return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - time).count() / 1.0e6;
+}
@@ -0,0 +1,117 @@
+#ifndef PROGRESSIVERENDERER_H
+#define PROGRESSIVERENDERER_H
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <mutex>
+
+#include "glm/glm.hpp"
+
+#include "Camera.h"
+#include "Ray.h"
+#include "RayPacket.h"
+#include "Scene.h"
+#include "PathIntegrator.h"
+#include "AovBuffer.h"
+
+#include "objects/Object.h"
+#include "objects/meshes/HitRecord.h"
+
+#include "thread/ThreadPool.h"
+#include "thread/WorkItem.h"
+
+#include "samplers/Sampler.h"
+
+#include "utils/random.h"
+
+
+// Renders the image in passes of one sample per pixel, summed into a float buffer,
+// until a number of passes or a time budget is reached. There is no barrier between
+// passes, a tile queues its next pass as soon as it finishes one, with the pass as
+// priority so that no tile gets ahead of the others. Whether there is a next pass is
+// decided once, by the first tile to finish the current one, and a pass that has
+// started is always completed. Every pixel therefore ends with the same number of
+// samples and the image is the exact mean of the completed passes.
+class ProgressiveRenderer {
+
+public:
+  // Called with the mean radiance of each pixel so far, row by row from the top left
+  typedef std::function<void(const std::vector<glm::vec3>& colors)> Output;
+
+  ProgressiveRenderer(const Scene& scene,
+                      const PathIntegrator& integrator,
+                      const Camera& camera,
+                      ThreadPool& threadPool,
+                      const bool packetTracing,
+                      const Sampler& sampler);
+
+  // Mean radiance of each pixel after at most maxPasses passes. A timeBudget in seconds
+  // above 0 stops starting passes that are expected to end after it. With an outputInterval
+  // in seconds above 0, output is called with the image so far at most that often.
+  // The samples of the passes are added to aovs when given.
+  std::vector<glm::vec3> render(const unsigned int maxPasses,
+                                const double timeBudget,
+                                const double outputInterval,
+                                Output output,
+                                AovBuffer* aovs = nullptr);
+
+  // Passes completed by the last call to render()
+  unsigned int getPasses() const { return passes_; }
+
+protected:
+
+private:
+  static const unsigned int tileSize_ = 8;
+
+  typedef std::chrono::high_resolution_clock Clock;
+
+  const Scene& scene_;
+  const PathIntegrator& integrator_;
+  const Camera& camera_;
+  ThreadPool& threadPool_;
+  const bool packetTracing_;
+  const Sampler& sampler_;
+
+  // Guards the buffer, the passes of the tiles and the decisions below
+  std::mutex lock_;
+
+  // One output at a time, the image may be written while tiles keep rendering
+  std::mutex outputLock_;
+
+  std::vector<glm::vec3> sums_;
+  std::vector<unsigned int> tilePasses_;
+
+  // Passes that will be rendered, grows by one while the limits allow
+  unsigned int passes_;
+  bool stopped_;
+
+  unsigned int maxPasses_;
+  double timeBudget_;
+  double outputInterval_;
+  Output output_;
+  AovBuffer* aovs_;
+
+  Clock::time_point startTime_;
+  Clock::time_point lastOutputTime_;
+
+  // Queues pass of tile on the pool, the work item queues the pass after it
+  void queue(const unsigned int tile, const unsigned int pass);
+
+  // Adds sample pass to every pixel of tile and counts the pass
+  void renderTile(const unsigned int tile, const unsigned int pass);
+
+  // Whether the pass after pass should be rendered, called with lock_ held
+  bool continues(const unsigned int pass);
+
+  // Mean of the passes of each tile so far, called with lock_ held
+  std::vector<glm::vec3> getColors() const;
+
+  double getSeconds(const Clock::time_point& time) const;
+
+};
+
+
+#endif // PROGRESSIVERENDERER_H
@@ -0,0 +1,193 @@
+#include "RayPacket.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RAY_PACKET_SIMD
+#include <immintrin.h>
+#endif
+
+
+const unsigned int RayPacket::maxSize;
+
+
+RayPacket::RayPacket() {
+  clear();
+}
+
+
+void RayPacket::clear() {
+  size_ = 0;
+  direction_ = glm::vec3{0.0f, 0.0f, 0.0f};
+  coherent_ = false;
+}
+
+
+void RayPacket::add(const Ray* ray) {
+  const glm::vec3 origin = ray->getOrigin();
+  const glm::vec3 inversedDirection = ray->getInversedDirection();
+
+  rays_[size_] = ray;
+  originX_[size_] = origin.x;
+  originY_[size_] = origin.y;
+  originZ_[size_] = origin.z;
+  inversedDirectionX_[size_] = inversedDirection.x;
+  inversedDirectionY_[size_] = inversedDirection.y;
+  inversedDirectionZ_[size_] = inversedDirection.z;
+  size_++;
+
+  direction_ += ray->getDirection();
+}
+
+
+void RayPacket::complete() {
+  coherent_ = size_ > 0;
+  if( !coherent_ ) {
+    return;
+  }
+
+  originMin_ = originMax_ = getOrigin(0);
+  inversedDirectionMin_ = inversedDirectionMax_ = rays_[0]->getInversedDirection();
+
+  for(unsigned int i=1; i<size_; i++) {
+    const glm::vec3 origin = getOrigin(i);
+    const glm::vec3 inversedDirection{inversedDirectionX_[i], inversedDirectionY_[i], inversedDirectionZ_[i]};
+    originMin_ = glm::min(originMin_, origin);
+    originMax_ = glm::max(originMax_, origin);
+    inversedDirectionMin_ = glm::min(inversedDirectionMin_, inversedDirection);
+    inversedDirectionMax_ = glm::max(inversedDirectionMax_, inversedDirection);
+  }
+
+  // Every axis needs a single, finite sign for the interval arithmetic to hold
+  const float infinity = std::numeric_limits<float>::infinity();
+  for(unsigned int axis=0; axis<3; axis++) {
+    const bool positive = inversedDirectionMin_[axis] > 0.0f && inversedDirectionMax_[axis] < infinity;
+    const bool negative = inversedDirectionMax_[axis] < 0.0f && inversedDirectionMin_[axis] > -infinity;
+    if( !positive && !negative ) {
+      coherent_ = false;
+    }
+  }
+}
+
+
+bool RayPacket::intersectFrustum(const BoundingBox& bounds, const float tMax) const {
+  const glm::vec3 boundsMin = bounds.getMin();
+  const glm::vec3 boundsMax = bounds.getMax();
+
+  float entry = 0.0f;
+  float exit = tMax;
+
+  for(unsigned int axis=0; axis<3; axis++) {
+    const bool positive = inversedDirectionMin_[axis] > 0.0f;
+    const float entryPlane = positive ? boundsMin[axis] : boundsMax[axis];
+    const float exitPlane = positive ? boundsMax[axis] : boundsMin[axis];
+
+    // Interval arithmetic over all origins and inversed directions of the packet
+    const float entry1 = (entryPlane - originMax_[axis]) * inversedDirectionMin_[axis];
+    const float entry2 = (entryPlane - originMax_[axis]) * inversedDirectionMax_[axis];
+    const float entry3 = (entryPlane - originMin_[axis]) * inversedDirectionMin_[axis];
+    const float entry4 = (entryPlane - originMin_[axis]) * inversedDirectionMax_[axis];
+    const float exit1 = (exitPlane - originMax_[axis]) * inversedDirectionMin_[axis];
+    const float exit2 = (exitPlane - originMax_[axis]) * inversedDirectionMax_[axis];
+    const float exit3 = (exitPlane - originMin_[axis]) * inversedDirectionMin_[axis];
+    const float exit4 = (exitPlane - originMin_[axis]) * inversedDirectionMax_[axis];
+
+    entry = std::max(entry, std::min(std::min(entry1, entry2), std::min(entry3, entry4)));
+    exit = std::min(exit, std::max(std::max(exit1, exit2), std::max(exit3, exit4)));
+  }
+
+  return entry <= exit;
+}
+
+
+#ifdef RAY_PACKET_SIMD
+
+unsigned long long RayPacket::intersect(const BoundingBox& bounds, const unsigned long long mask, const float* tMax) const {
+  const glm::vec3 boundsMin = bounds.getMin();
+  const glm::vec3 boundsMax = bounds.getMax();
+
+  const __m128 minX = _mm_set1_ps(boundsMin.x);
+  const __m128 minY = _mm_set1_ps(boundsMin.y);
+  const __m128 minZ = _mm_set1_ps(boundsMin.z);
+  const __m128 maxX = _mm_set1_ps(boundsMax.x);
+  const __m128 maxY = _mm_set1_ps(boundsMax.y);
+  const __m128 maxZ = _mm_set1_ps(boundsMax.z);
+  const __m128 zero = _mm_setzero_ps();
+
+  unsigned long long hits = 0;
+
+  for(unsigned int i=0; i<size_; i+=4) {
+    if( !((mask >> i) & 0xfull) ) {
+      continue;
+    }
+
+    const __m128 ox = _mm_load_ps(originX_ + i);
+    const __m128 oy = _mm_load_ps(originY_ + i);
+    const __m128 oz = _mm_load_ps(originZ_ + i);
+    const __m128 ix = _mm_load_ps(inversedDirectionX_ + i);
+    const __m128 iy = _mm_load_ps(inversedDirectionY_ + i);
+    const __m128 iz = _mm_load_ps(inversedDirectionZ_ + i);
+
+    const __m128 tx1 = _mm_mul_ps(_mm_sub_ps(minX, ox), ix);
+    const __m128 tx2 = _mm_mul_ps(_mm_sub_ps(maxX, ox), ix);
+    const __m128 ty1 = _mm_mul_ps(_mm_sub_ps(minY, oy), iy);
+    const __m128 ty2 = _mm_mul_ps(_mm_sub_ps(maxY, oy), iy);
+    const __m128 tz1 = _mm_mul_ps(_mm_sub_ps(minZ, oz), iz);
+    const __m128 tz2 = _mm_mul_ps(_mm_sub_ps(maxZ, oz), iz);
+
+    __m128 sMin = _mm_max_ps(_mm_min_ps(tx1, tx2), zero);
+    __m128 sMax = _mm_min_ps(_mm_max_ps(tx1, tx2), _mm_loadu_ps(tMax + i));
+    sMin = _mm_max_ps(sMin, _mm_min_ps(ty1, ty2));
+    sMax = _mm_min_ps(sMax, _mm_max_ps(ty1, ty2));
+    sMin = _mm_max_ps(sMin, _mm_min_ps(tz1, tz2));
+    sMax = _mm_min_ps(sMax, _mm_max_ps(tz1, tz2));
+
+    hits |= (unsigned long long) _mm_movemask_ps(_mm_cmple_ps(sMin, sMax)) << i;
+  }
+
+  return hits & mask;
+}
+
+
+float RayPacket::getFarthest(const float* tMax) const {
+  __m128 farthest = _mm_setzero_ps();
+  unsigned int i = 0;
+  for(; i+4<=size_; i+=4) {
+    farthest = _mm_max_ps(farthest, _mm_loadu_ps(tMax + i));
+  }
+
+  float lanes[4];
+  _mm_storeu_ps(lanes, farthest);
+  float result = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+  for(; i<size_; i++) {
+    result = std::max(result, tMax[i]);
+  }
+  return result;
+}
+
+#else
+
+unsigned long long RayPacket::intersect(const BoundingBox& bounds, const unsigned long long mask, const float* tMax) const {
+  unsigned long long hits = 0;
+  float tNear;
+
+  for(unsigned int i=0; i<size_; i++) {
+    const unsigned long long bit = 1ull << i;
+    if( (mask & bit) && bounds.intersect(getOrigin(i), 
+                                         glm::vec3{inversedDirectionX_[i], inversedDirectionY_[i], inversedDirectionZ_[i]}, 
+                                         tMax[i], tNear) ) {
+      hits |= bit;
+    }
+  }
+
+  return hits;
+}
+
+
+float RayPacket::getFarthest(const float* tMax) const {
+  float result = 0.0f;
+  for(unsigned int i=0; i<size_; i++) {
+    result = std::max(result, tMax[i]);
+  }
+  return result;
+}
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef RAYPACKET_H
+#define RAYPACKET_H
+
+#include <limits>
+#include <algorithm>
+
+#include "glm/glm.hpp"
+
+#include "Ray.h"
+#include "acceleration/BoundingBox.h"
+
+
+// Up to 64 coherent rays that traverse the acceleration structures together, 
+// one bit per ray in the masks. The rays are bounded by a shared frustum, the 
+// interval of their origins and inversed directions, which lets the whole packet 
+// skip a node with a single box test.
+class RayPacket {
+
+public:
+  static const unsigned int maxSize = 64;
+
+  RayPacket();
+
+  void clear();
+
+  void add(const Ray* ray);
+
+  // Computes the frustum, call once all rays are added
+  void complete();
+
+  unsigned int getSize() const { return size_; }
+
+  unsigned long long getMask() const { return size_ == maxSize ? ~0ull : (1ull << size_) - 1; }
+
+  const Ray* getRay(const unsigned int index) const { return rays_[index]; }
+
+  glm::vec3 getOrigin(const unsigned int index) const { return glm::vec3{originX_[index], originY_[index], originZ_[index]}; }
+
+  // Sum of the directions, used to order the children during traversal
+  glm::vec3 getDirection() const { return direction_; }
+
+  // The frustum is only valid when the directions of all rays share their signs, 
+  // packets that are not coherent have to be traced as single rays.
+  bool isCoherent() const { return coherent_; }
+
+  // Conservative test of the whole packet, false only if no ray can hit the box before tMax
+  bool intersectFrustum(const BoundingBox& bounds, const float tMax) const;
+
+  // Box test of each ray in mask against its own tMax, returns the rays that hit
+  unsigned long long intersect(const BoundingBox& bounds, const unsigned long long mask, const float* tMax) const;
+
+  // Largest of the distances in tMax, one per ray
+  float getFarthest(const float* tMax) const;
+
+protected:
+
+private:
+  unsigned int size_;
+  const Ray* rays_[maxSize];
+
+  // Aligned for the SSE loops, which also read the unused lanes past size_
+  alignas(16) float originX_[maxSize];
+  alignas(16) float originY_[maxSize];
+  alignas(16) float originZ_[maxSize];
+  alignas(16) float inversedDirectionX_[maxSize];
+  alignas(16) float inversedDirectionY_[maxSize];
+  alignas(16) float inversedDirectionZ_[maxSize];
+
+  glm::vec3 direction_;
+  glm::vec3 originMin_;
+  glm::vec3 originMax_;
+  glm::vec3 inversedDirectionMin_;
+  glm::vec3 inversedDirectionMax_;
+  bool coherent_;
+
+};
+
+
+#endif // RAYPACKET_H
@@ -1,6 +1,9 @@
 #include "Scene.h"
 
 
+const unsigned int Scene::shadowRayBatch_;
+
+
 Scene::~Scene() {
   for(unsigned int i=0; i<objects_.size(); i++) {
     delete objects_[i];
@@ -9,12 +12,72 @@ Scene::~Scene() {
 
 
 void Scene::add(Object* object) {
+  object->setId(objects_.size());
   objects_.push_back(object);
 }
 
 
-std::pair<Object*, glm::vec3> Scene::intersect(const Ray* ray) const {
-  return intersectImpl(ray, objects_);
+std::pair<Object*, HitRecord> Scene::intersect(const Ray* ray) const {
+  BvhStatistics::addRay(objectBvh_.getWidth());
+  return intersectImpl(ray, objects_, objectBvh_);
+}
+
+
+void Scene::intersect(const RayPacket& packet, std::pair<Object*, HitRecord>* intersections) const {
+  if( !packet.isCoherent() ) {
+    for(unsigned int i=0; i<packet.getSize(); i++) {
+      intersections[i] = intersect(packet.getRay(i));
+    }
+    return;
+  }
+
+  float inversedLengths[RayPacket::maxSize];
+  float nearestHitDistances[RayPacket::maxSize];
+
+  for(unsigned int i=0; i<packet.getSize(); i++) {
+    // Coherent packets traverse the binary nodes
+    BvhStatistics::addRay(2);
+    inversedLengths[i] = 1.0f / glm::length(packet.getRay(i)->getDirection());
+    nearestHitDistances[i] = std::numeric_limits<float>::max();
+    intersections[i] = std::pair<Object*, HitRecord>{nullptr, HitRecord{}};
+  }
+
+  HitRecord hits[RayPacket::maxSize];
+
+  objectBvh_.intersectPacket(packet, packet.getMask(), nearestHitDistances, [&](const unsigned int index, const unsigned long long rayMask, float* tMax) {
+    Object* object = objects_[index];
+    const unsigned long long objectHits = object->intersect(packet, rayMask, hits);
+
+    unsigned long long closer = 0;
+    for(unsigned int i=0; i<packet.getSize(); i++) {
+      const unsigned long long bit = 1ull << i;
+      if( objectHits & bit ) {
+        const float distance = glm::length(hits[i].position - packet.getOrigin(i)) * inversedLengths[i];
+        if( distance < tMax[i] ) {
+          intersections[i] = std::pair<Object*, HitRecord>{object, hits[i]};
+          tMax[i] = distance;
+          closer |= bit;
+        }
+      }
+    }
+
+    return closer;
+  });
+}
+
+
+bool Scene::isOccluded(const glm::vec3& origin, const glm::vec3& target, const Object* ignore) const {
+  const glm::vec3 segment = target - origin;
+  const float distance = glm::length(segment);
+  const Ray ray{origin, segment / distance};
+  const float tMax = distance - getEpsilon();
+
+  BvhStatistics::addRay(opaqueObjectBvh_.getWidth());
+
+  return opaqueObjectBvh_.occluded(&ray, tMax, [&](const unsigned int index) {
+    const Object* object = opaqueObjects_[index];
+    return object != ignore && object->occludes(&ray, tMax);
+  });
 }
 
 
@@ -23,7 +86,7 @@ void Scene::complete() {
     if( object->isLight() ) {
       lightObjects_.push_back(object);
     } 
-    if( object->isTransparent() && dynamic_cast<TransparentObject*>(object)->getTransparancy() > 0.0f ) {
+    if( object->isTransparent() && static_cast<TransparentObject*>(object)->getTransparancy() > 0.0f ) {
       transparentObjects_.push_back(object);
     } else {
       opaqueObjects_.push_back(object);
@@ -33,101 +96,156 @@ void Scene::complete() {
   if( lightObjects_.empty() ) {
     throw std::invalid_argument{"The scene is missing a light source."};
   }
+
+  buildLights();
+  buildBvh(objectBvh_, objects_);
+  buildBvh(opaqueObjectBvh_, opaqueObjects_);
+}
+
+
+void Scene::buildLights() {
+  // Lights are picked by the power they emit
+  std::vector<float> lightPowers;
+  for(auto& light: lightObjects_) {
+    const glm::vec3 intensity = light->getIntensity();
+    lightPowers.push_back(light->getArea() * (intensity.r + intensity.g + intensity.b) / 3.0f);
+  }
+  lightTable_ = AliasTable{lightPowers};
+
+  if( useLightBvh_ ) {
+    lightBvh_.build(lightObjects_, lightPowers);
+  }
+}
+
+
+void Scene::setTransform(const std::string& name, const glm::mat4& transform) {
+  for(auto& object: objects_) {
+    if( object->getName() == name ) {
+      object->setTransform(transform);
+      return;
+    }
+  }
+  throw std::invalid_argument{"The scene has no object called " + name + "."};
 }
 
 
-std::pair<Object*, glm::vec3> Scene::intersectImpl(const Ray* ray, const std::vector<Object*>& theObjectVector) const {
+void Scene::refit() {
+  // Moved lights change the light BVH and scaled ones their power
+  buildLights();
+  refitBvh(objectBvh_, objects_);
+  refitBvh(opaqueObjectBvh_, opaqueObjects_);
+}
+
+
+void Scene::buildBvh(Bvh& bvh, const std::vector<Object*>& theObjectVector) const {
+  bvh.build(getBounds(theObjectVector));
+}
+
+
+void Scene::refitBvh(Bvh& bvh, const std::vector<Object*>& theObjectVector) const {
+  bvh.refit(getBounds(theObjectVector));
+}
+
+
+std::vector<BoundingBox> Scene::getBounds(const std::vector<Object*>& theObjectVector) const {
+  std::vector<BoundingBox> objectBounds;
+  objectBounds.reserve(theObjectVector.size());
+
+  for(auto& object: theObjectVector) {
+    objectBounds.push_back(object->getBounds());
+  }
+
+  return objectBounds;
+}
+
+
+std::pair<Object*, HitRecord> Scene::intersectImpl(const Ray* ray, const std::vector<Object*>& theObjectVector, const Bvh& bvh) const {
   const glm::vec3 origin = ray->getOrigin();
+  const float inversedLength = 1.0f / glm::length(ray->getDirection());
 
+  // Distances along the ray in units of its direction, as used by the bounding box tests
   float nearestHitDistance{std::numeric_limits<float>::max()};
 
-  std::pair<Object*, glm::vec3> nearestHit{nullptr, glm::vec3{0}};
+  std::pair<Object*, HitRecord> nearestHit{nullptr, HitRecord{}};
 
-  for(auto& object: theObjectVector) {
-    std::pair<Object::Intersection, glm::vec3> intersection = object->intersect(ray);
+  bvh.intersect(ray, nearestHitDistance, [&](const unsigned int index, float& tMax) {
+    Object* object = theObjectVector[index];
+    const std::pair<Object::Intersection, HitRecord> intersection = object->intersect(ray);
     
     if( intersection.first == Object::Intersection::HIT ) {
-      // const float distance = glm::distance(intersection.second, origin);
-      const float distance = glm::length(intersection.second - origin);
-      if( distance < nearestHitDistance ) {
-        nearestHit = std::pair<Object*, glm::vec3>{object, intersection.second};
-        // nearestHit = std::make_pair(object, intersection.second);
-        nearestHitDistance = distance;
-         // return nearestHit;
+      const float distance = glm::length(intersection.second.position - origin) * inversedLength;
+      if( distance < tMax ) {
+        nearestHit = std::pair<Object*, HitRecord>{object, intersection.second};
+        tMax = distance;
+        return true;
       }
     }
 
-  }
+    return false;
+  });
 
   return nearestHit;
 }
 
 
 glm::vec3 Scene::castShadowRays(const glm::vec3& trueOrigin, 
-                                const glm::vec2 incomingAngles,
+                                const glm::vec3& incoming,
                                 Object* object,
                                 const unsigned int numberOfShadowRaysToLaunch,
                                 const glm::vec3& trueNormal,
-                                const glm::vec2& trueNormalAngles) const {
+                                RandomSequence& sequence) const {
 
   glm::vec3 intensity{0, 0, 0};
 
-  for(unsigned int i=0; i<lightObjects_.size(); i++) {
+  const Frame frame{trueNormal};
+
+  const unsigned int firstDimension = sequence.getDimension();
+  float lightSamples[shadowRayBatch_];
+
+  // Each shadow ray goes to one light, dividing by the probability of the pick keeps 
+  // the sum over all lights in expectation at a cost independent of their number
+  for(unsigned int r=0; r<numberOfShadowRaysToLaunch; r++) {
+    unsigned int i;
+    float probability;
+
+    // Both are drawn up front, every shadow ray takes the same two dimensions
+    if( r % shadowRayBatch_ == 0 ) {
+      sequence.setDimension(firstDimension + r);
+      sequence.next0To1(lightSamples, std::min(shadowRayBatch_, numberOfShadowRaysToLaunch - r));
+    }
+    const float lightSample = lightSamples[r % shadowRayBatch_];
+    sequence.setDimension(firstDimension + numberOfShadowRaysToLaunch + r);
+    const glm::vec2 surfaceSample = sequence.next2D();
+
+    if( useLightBvh_ ) {
+      if( !lightBvh_.sample(trueOrigin, trueNormal, lightSample, i, probability) ) {
+        continue; // No light reaches the origin
+      }
+    } else {
+      i = lightTable_.sample(lightSample);
+      probability = lightTable_.getProbability(i);
+    }
 
-    glm::vec3 contribution{0, 0, 0};
     const float area = lightObjects_[i]->getArea();
     const glm::vec3 light = lightObjects_[i]->getIntensity();
 
-    for(unsigned int r=0; r<numberOfShadowRaysToLaunch; r++) {
-      const glm::vec3 randomLightPosition = lightObjects_[i]->getRandomSurfacePosition();
-      const glm::vec3 shadowVector = randomLightPosition - trueOrigin;
-      const Ray* ray = new Ray{trueOrigin, glm::normalize(shadowVector)};
-      const std::pair<Object*, glm::vec3> intersection = intersectImpl(ray, opaqueObjects_);
-      // const std::tuple<Object*, glm::vec3, glm::vec3> hit = hitImpl(ray, opaqueObjects_);
-
-      if( intersection.first == lightObjects_[i] ) {
-      // if( std::get<0>(hit) == lightObjects_[i] ) {
-        // const glm::vec3 origin = ray->getOrigin();
-        const glm::vec3 direction = ray->getDirection();
-        const glm::vec3 normal = intersection.first->getNormal(intersection.second);
-        // const glm::vec3 normal = std::get<2>(hit);
-        float inclination = std::acos(glm::dot(-direction, normal));
-        // glm::vec3 directionFlipped = -direction;
-        // glm::vec2 d0 = {std::acos(directionFlipped.z), 
-        //                  std::atan2(directionFlipped.y, directionFlipped.x)};
-        // glm::vec2 d5 = {std::acos(normal.z), 
-        //          std::atan2(normal.y, normal.x)};
-        // float inclination = d5.x - d0.x;
-
-         glm::vec2 d1 = {std::acos(direction.z), 
-                         std::atan2(direction.y, direction.x)};
-         // glm::vec2 fakeNormalAngels = {std::acos(normal.z), 
-         //                 std::atan2(normal.y, normal.x)};
-
-        // float inclination = std::acos(glm::dot(-direction, trueNormal));
-        // glm::vec3 hemisphereOutgoingDirection = glm::inverse(rotation) * -direction;
-
-         glm::vec2 outgoingAngles = d1 - trueNormalAngles;
-         // glm::vec2 outgoingAngles = d1 - fakeNormalAngels;
-        
-        // const float brdf = dynamic_cast<OpaqueObject*>(object)->computeBrdf(intersection.second, incomingAngles, outgoingAngles);
-        const float brdf = dynamic_cast<OpaqueObject*>(object)->computeBrdf(trueOrigin, incomingAngles, outgoingAngles);
-        // const float brdf = dynamic_cast<OpaqueObject*>(object)->computeBrdf(std::get<1>(hit), incomingAngles, outgoingAngles);
-
-        const float geometric = (std::cos(inclination)*std::cos(outgoingAngles.x) ) / (glm::dot(shadowVector, shadowVector) );
-
-        contribution += brdf * geometric;
-        // contribution += brdf;
-        // contribution += geometric;
-      } 
-      // else {
-      //   contribution = glm::vec3{-0.5f, -0.5f, -0.5f};
-      // }
-
-      intensity += (area / (float) numberOfShadowRaysToLaunch) * contribution * light;
-      delete ray;
-    }
+    glm::vec3 normal;
+    const glm::vec3 randomLightPosition = lightObjects_[i]->getRandomSurfacePosition(surfaceSample, normal);
+    const glm::vec3 shadowVector = randomLightPosition - trueOrigin;
+    const glm::vec3 direction = glm::normalize(shadowVector);
+
+    const glm::vec3 outgoing = frame.toLocal(direction);
 
+    // The light only contributes when its sampled side faces the origin, it lies above the 
+    // surface and nothing blocks the way
+    const float cosLight = glm::dot(-direction, normal);
+    if( cosLight > 0.0f && outgoing.z > 0.0f && !isOccluded(trueOrigin, randomLightPosition, lightObjects_[i]) ) {
+      const float brdf = static_cast<OpaqueObject*>(object)->computeBrdf(trueOrigin, incoming, outgoing);
+
+      const float geometric = (cosLight * outgoing.z) / glm::dot(shadowVector, shadowVector);
+
+      intensity += (area / (probability * numberOfShadowRaysToLaunch)) * brdf * geometric * light;
+    }
   }
 
   return intensity;
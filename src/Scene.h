@@ -7,6 +7,7 @@
 #include <tuple>
 #include <limits>
 #include <stdexcept>
+#include <string>
 
 #include "glm/glm.hpp"
 
@@ -14,10 +15,16 @@
 #include "objects/OpaqueObject.h"
 #include "objects/TransparentObject.h"
 
+#include "RayPacket.h"
+
+#include "acceleration/Bvh.h"
+#include "acceleration/LightBvh.h"
+
 #include "utils/lightning.h"
 
 #include "utils/math.h"
 #include "utils/random.h"
+#include "utils/AliasTable.h"
 
 
 class Scene {
@@ -29,26 +36,68 @@ public:
   
   void add(Object* object);
 
-  std::pair<Object*, glm::vec3> intersect(const Ray* ray) const;
+  std::pair<Object*, HitRecord> intersect(const Ray* ray) const;
+
+  // Nearest hits of all rays in the packet, one entry per ray in intersections. 
+  // Packets that are not coherent are traced one ray at a time.
+  void intersect(const RayPacket& packet, std::pair<Object*, HitRecord>* intersections) const;
 
+  // Returns true as soon as any opaque object other than ignore blocks the segment from origin to target
+  bool isOccluded(const glm::vec3& origin, const glm::vec3& target, const Object* ignore = nullptr) const;
+
+  // Direct light at origin estimated with numberOfShadowRaysToLaunch shadow rays in total, 
+  // each to a light picked in proportion to its power, or by the light BVH when enabled. 
+  // Incoming is the direction the light leaves towards, in the shading frame of trueNormal. 
+  // The shadow rays take the next n dimensions of sequence for their lights, drawn in 
+  // batches, and the n after those for the points on the lights.
   glm::vec3 castShadowRays(const glm::vec3& origin, 
-                           const glm::vec2 incomingAngles,
+                           const glm::vec3& incoming,
                            Object* object,
                            const unsigned int numberOfShadowRaysToLaunch, 
                            const glm::vec3& trueNormal,
-                           const glm::vec2& trueNormalAngles) const;
+                           RandomSequence& sequence) const;
+
+  // Picks the lights of the shadow rays by their position and orientation relative to the 
+  // shading point instead of by power alone, pays off for many lights. Call before complete().
+  void setLightBvh(const bool enabled) { useLightBvh_ = enabled; }
 
   void complete();
 
+  // Moves the object called name, for instance from one frame to the next. 
+  // Call refit() once all objects of the frame have been placed.
+  void setTransform(const std::string& name, const glm::mat4& transform);
+
+  // Refits the object hierarchies to the current bounds of the objects, 
+  // they are rebuilt once refitting has degraded them too much. The light 
+  // table and light BVH are rebuilt, lights are few compared to objects.
+  void refit();
+
 protected:
 
 private:
+  // Light picks of the shadow rays drawn in one batch
+  static const unsigned int shadowRayBatch_ = 16;
+
   std::vector<Object*> objects_;
   std::vector<Object*> lightObjects_;
   std::vector<Object*> transparentObjects_;
   std::vector<Object*> opaqueObjects_;
 
-  inline std::pair<Object*, glm::vec3> intersectImpl(const Ray* ray, const std::vector<Object*>& theObjectVector) const;
+  // Picks from lightObjects_ in proportion to their power
+  AliasTable lightTable_;
+
+  bool useLightBvh_ = false;
+  LightBvh lightBvh_;
+
+  Bvh objectBvh_;
+  Bvh opaqueObjectBvh_;
+
+  void buildLights();
+  void buildBvh(Bvh& bvh, const std::vector<Object*>& theObjectVector) const;
+  void refitBvh(Bvh& bvh, const std::vector<Object*>& theObjectVector) const;
+  std::vector<BoundingBox> getBounds(const std::vector<Object*>& theObjectVector) const;
+
+  inline std::pair<Object*, HitRecord> intersectImpl(const Ray* ray, const std::vector<Object*>& theObjectVector, const Bvh& bvh) const;
 };
 
 #endif // SCENE_H
\ No newline at end of file
@@ -0,0 +1,313 @@
+#include "WavefrontIntegrator.h"
+
+
+const unsigned int WavefrontIntegrator::maxBatchSize_;
+const unsigned int WavefrontIntegrator::chunkSize_;
+const unsigned int WavefrontIntegrator::tileSize_;
+
+
+WavefrontIntegrator::WavefrontIntegrator(const Scene& scene,
+                                         const PathIntegrator& integrator,
+                                         const Camera& camera,
+                                         ThreadPool& threadPool,
+                                         const bool packetTracing,
+                                         const Sampler& sampler)
+: scene_(scene)
+, integrator_(integrator)
+, camera_(camera)
+, threadPool_(threadPool)
+, packetTracing_{packetTracing}
+, sampler_(sampler)
+, queueSize_{0}
+, extendedRays_{0}
+{
+  std::fill(microseconds_, microseconds_ + numberOfStages, 0);
+}
+
+
+std::vector<glm::vec3> WavefrontIntegrator::render(const unsigned int numberOfSamples, AovBuffer* aovs) {
+  const glm::ivec2 pixels = camera_.getPixels();
+  const unsigned int width = pixels.x;
+  const unsigned int height = pixels.y;
+  const unsigned int tilesX = (width + tileSize_ - 1) / tileSize_;
+  const unsigned int tilesY = (height + tileSize_ - 1) / tileSize_;
+  const unsigned int numberOfTiles = tilesX * tilesY;
+
+  std::vector<glm::vec3> colors(width * height, glm::vec3{0.0f, 0.0f, 0.0f});
+
+  // A full tile is the largest, batches hold at least one
+  const unsigned int pathsPerTile = tileSize_ * tileSize_ * numberOfSamples;
+  const unsigned int tilesPerBatch = std::max(1u, maxBatchSize_ / pathsPerTile);
+
+  for(unsigned int firstTile=0; firstTile<numberOfTiles; firstTile+=tilesPerBatch) {
+    const unsigned int batchTiles = std::min(tilesPerBatch, numberOfTiles - firstTile);
+
+    time(Stage::GENERATE, [&]() { generate(firstTile, batchTiles, numberOfSamples); });
+
+    // Only the camera rays are coherent enough to be traced as packets
+    bool cameraRays = true;
+
+    while( queueSize_ > 0 ) {
+      time(Stage::EXTEND, [&]() { extend(packetTracing_ && cameraRays); });
+
+      // The queue of the first bounce holds every path of the batch in order
+      if( aovs != nullptr ) {
+        if( cameraRays ) {
+          surfaces_.resize(pixels_.size());
+          for(unsigned int path=0; path<pixels_.size(); path++) {
+            surfaces_[path] = PathIntegrator::FirstSurface{intersections_[path]};
+          }
+          direct_.assign(pixels_.size(), glm::vec3{0.0f, 0.0f, 0.0f});
+          pastFirstSurface_.assign(pixels_.size(), 0);
+        } else {
+          for(unsigned int i=0; i<queueSize_; i++) {
+            surfaces_[queue_.paths[i]].follow(intersections_[i]);
+          }
+        }
+      }
+
+      time(Stage::SHADE, [&]() { shade(); });
+      time(Stage::CONNECT, [&]() { connect(); });
+
+      // Transparent surfaces add no light, the radiance of a path that has just been shaded 
+      // at its first surface that is not transparent is its direct light
+      if( aovs != nullptr ) {
+        for(unsigned int i=0; i<queueSize_; i++) {
+          const unsigned int path = queue_.paths[i];
+          const Object* object = intersections_[i].first;
+          if( !pastFirstSurface_[path] && (object == nullptr || !object->isTransparent()) ) {
+            direct_[path] = radiance_[path];
+            pastFirstSurface_[path] = 1;
+          }
+        }
+      }
+
+      time(Stage::COMPACT, [&]() { compact(); });
+      cameraRays = false;
+    }
+
+    for(unsigned int path=0; path<pixels_.size(); path++) {
+      colors[pixels_[path]] += radiance_[path];
+    }
+
+    if( aovs != nullptr ) {
+      for(unsigned int path=0; path<pixels_.size(); path++) {
+        aovs->add(pixels_[path], surfaces_[path], radiance_[path], direct_[path]);
+      }
+    }
+  }
+
+  for(glm::vec3& color : colors) {
+    color /= (float)numberOfSamples;
+  }
+
+  return colors;
+}
+
+
+void WavefrontIntegrator::generate(const unsigned int firstTile, const unsigned int numberOfTiles, const unsigned int numberOfSamples) {
+  const glm::ivec2 pixels = camera_.getPixels();
+  const unsigned int width = pixels.x;
+  const unsigned int height = pixels.y;
+  const unsigned int tilesX = (width + tileSize_ - 1) / tileSize_;
+
+  // The paths of a tile follow each other, sample by sample
+  std::vector<unsigned int> tileOffsets(numberOfTiles + 1, 0);
+  for(unsigned int tile=0; tile<numberOfTiles; tile++) {
+    const unsigned int tileX = ((firstTile + tile) % tilesX) * tileSize_;
+    const unsigned int tileY = ((firstTile + tile) / tilesX) * tileSize_;
+    const unsigned int numberOfPixels = std::min(tileSize_, width - tileX) * std::min(tileSize_, height - tileY);
+    tileOffsets[tile + 1] = tileOffsets[tile] + numberOfPixels * numberOfSamples;
+  }
+
+  queueSize_ = tileOffsets[numberOfTiles];
+
+  queue_.resize(queueSize_);
+  compacted_.resize(queueSize_);
+  intersections_.resize(queueSize_);
+  shadowConnections_.resize(queueSize_);
+  continues_.resize(queueSize_);
+  shadingOrder_.resize(queueSize_);
+
+  pixels_.resize(queueSize_);
+  radiance_.assign(queueSize_, glm::vec3{0.0f, 0.0f, 0.0f});
+
+  for(unsigned int tile=0; tile<numberOfTiles; tile++) {
+    threadPool_.add(new WorkItem([this, &tileOffsets, tile, firstTile, tilesX, width, height, numberOfSamples]() {
+      const unsigned int tileX = ((firstTile + tile) % tilesX) * tileSize_;
+      const unsigned int tileY = ((firstTile + tile) / tilesX) * tileSize_;
+      const unsigned int tileWidth = std::min(tileSize_, width - tileX);
+      const unsigned int tileHeight = std::min(tileSize_, height - tileY);
+
+      Camera::RowBasis rowBases[tileSize_];
+      for(unsigned int y=0; y<tileHeight; y++) {
+        rowBases[y] = camera_.getRowBasis(tileY + y);
+      }
+
+      unsigned int path = tileOffsets[tile];
+      for(unsigned int s=0; s<numberOfSamples; s++) {
+        for(unsigned int y=0; y<tileHeight; y++) {
+          for(unsigned int x=tileX; x<tileX + tileWidth; x++) {
+            pixels_[path] = (tileY + y) * width + x;
+            queue_.sequences[path] = RandomSequence{&sampler_, pixels_[path], s};
+            const Ray cameraRay = camera_.getRay(rowBases[y], x, queue_.sequences[path]);
+            queue_.paths[path] = path;
+            queue_.store(path, integrator_.begin(&cameraRay));
+            path++;
+          }
+        }
+      }
+    }));
+  }
+
+  threadPool_.wait();
+}
+
+
+void WavefrontIntegrator::extend(const bool packets) {
+  forEachChunk(queueSize_, [this, packets](const unsigned int, const unsigned int first, const unsigned int count) {
+    std::vector<Ray> rays;
+    rays.reserve(RayPacket::maxSize);
+    RayPacket packet;
+
+    for(unsigned int packetFirst=first; packetFirst<first + count; packetFirst+=RayPacket::maxSize) {
+      const unsigned int packetSize = std::min(RayPacket::maxSize, first + count - packetFirst);
+
+      rays.clear();
+      for(unsigned int i=packetFirst; i<packetFirst + packetSize; i++) {
+        rays.emplace_back(queue_.origins[i], queue_.directions[i]);
+      }
+
+      if( packets ) {
+        packet.clear();
+        for(unsigned int i=0; i<packetSize; i++) {
+          packet.add(&rays[i]);
+        }
+        packet.complete();
+        scene_.intersect(packet, &intersections_[packetFirst]);
+      } else {
+        for(unsigned int i=0; i<packetSize; i++) {
+          intersections_[packetFirst + i] = scene_.intersect(&rays[i]);
+        }
+      }
+    }
+  });
+
+  extendedRays_ += queueSize_;
+}
+
+
+void WavefrontIntegrator::shade() {
+  // Counting sort of the queue by material, the shading of each kind takes the same branches
+  unsigned int offsets[NUMBER_OF_MATERIALS + 1] = {0};
+  std::vector<unsigned char> materials(queueSize_);
+
+  for(unsigned int i=0; i<queueSize_; i++) {
+    const Object* object = intersections_[i].first;
+
+    if( object == nullptr ) {
+      materials[i] = MISS;
+    } else if( object->isLight() ) {
+      materials[i] = LIGHT;
+    } else if( object->isTransparent() ) {
+      materials[i] = TRANSPARENT;
+    } else {
+      materials[i] = OPAQUE;
+    }
+
+    offsets[materials[i] + 1]++;
+  }
+
+  for(unsigned int material=0; material<NUMBER_OF_MATERIALS; material++) {
+    offsets[material + 1] += offsets[material];
+  }
+
+  for(unsigned int i=0; i<queueSize_; i++) {
+    shadingOrder_[offsets[materials[i]]++] = i;
+  }
+
+  forEachChunk(queueSize_, [this](const unsigned int, const unsigned int first, const unsigned int count) {
+    for(unsigned int k=first; k<first + count; k++) {
+      const unsigned int i = shadingOrder_[k];
+      PathIntegrator::PathState path = queue_.load(i);
+      continues_[i] = integrator_.scatter(path, intersections_[i], radiance_[queue_.paths[i]], shadowConnections_[i], queue_.sequences[i]);
+      queue_.store(i, path);
+    }
+  });
+}
+
+
+void WavefrontIntegrator::connect() {
+  forEachChunk(queueSize_, [this](const unsigned int, const unsigned int first, const unsigned int count) {
+    for(unsigned int i=first; i<first + count; i++) {
+      if( shadowConnections_[i].object != nullptr ) {
+        radiance_[queue_.paths[i]] += integrator_.connect(shadowConnections_[i], queue_.sequences[i]);
+      }
+    }
+  });
+}
+
+
+void WavefrontIntegrator::compact() {
+  // Stable, each chunk counts its continuing paths and moves them after those of the chunks before it
+  const unsigned int numberOfChunks = (queueSize_ + chunkSize_ - 1) / chunkSize_;
+  std::vector<unsigned int> chunkOffsets(numberOfChunks + 1, 0);
+
+  forEachChunk(queueSize_, [this, &chunkOffsets](const unsigned int chunk, const unsigned int first, const unsigned int count) {
+    chunkOffsets[chunk + 1] = std::count(continues_.begin() + first, continues_.begin() + first + count, 1);
+  });
+
+  for(unsigned int chunk=0; chunk<numberOfChunks; chunk++) {
+    chunkOffsets[chunk + 1] += chunkOffsets[chunk];
+  }
+
+  forEachChunk(queueSize_, [this, &chunkOffsets](const unsigned int chunk, const unsigned int first, const unsigned int count) {
+    unsigned int index = chunkOffsets[chunk];
+    for(unsigned int i=first; i<first + count; i++) {
+      if( continues_[i] ) {
+        queue_.move(i, compacted_, index++);
+      }
+    }
+  });
+
+  queueSize_ = chunkOffsets[numberOfChunks];
+  std::swap(queue_, compacted_);
+}
+
+
+void WavefrontIntegrator::PathQueue::resize(const unsigned int size) {
+  paths.resize(size);
+  origins.resize(size);
+  directions.resize(size);
+  throughputs.resize(size);
+  refractionIndices.resize(size);
+  depths.resize(size);
+  sequences.resize(size);
+}
+
+
+PathIntegrator::PathState WavefrontIntegrator::PathQueue::load(const unsigned int index) const {
+  PathIntegrator::PathState path;
+  path.origin = origins[index];
+  path.direction = directions[index];
+  path.throughput = throughputs[index];
+  path.refractionIndex = refractionIndices[index];
+  path.depth = depths[index];
+  return path;
+}
+
+
+void WavefrontIntegrator::PathQueue::store(const unsigned int index, const PathIntegrator::PathState& path) {
+  origins[index] = path.origin;
+  directions[index] = path.direction;
+  throughputs[index] = path.throughput;
+  refractionIndices[index] = path.refractionIndex;
+  depths[index] = path.depth;
+}
+
+
+void WavefrontIntegrator::PathQueue::move(const unsigned int from, PathQueue& to, const unsigned int index) const {
+  to.paths[index] = paths[from];
+  to.sequences[index] = sequences[from];
+  to.store(index, load(from));
+}
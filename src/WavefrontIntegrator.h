@@ -0,0 +1,150 @@
+#ifndef WAVEFRONTINTEGRATOR_H
+#define WAVEFRONTINTEGRATOR_H
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <chrono>
+
+#include "glm/glm.hpp"
+
+#include "Camera.h"
+#include "Ray.h"
+#include "RayPacket.h"
+#include "Scene.h"
+#include "PathIntegrator.h"
+#include "AovBuffer.h"
+
+#include "objects/Object.h"
+#include "objects/meshes/HitRecord.h"
+
+#include "thread/ThreadPool.h"
+#include "thread/WorkItem.h"
+
+#include "samplers/Sampler.h"
+
+#include "utils/random.h"
+
+
+// Renders the image stage by stage instead of one path at a time. A batch of tiles
+// starts with the camera rays of all its samples in a queue with one array per field.
+// Every bounce then extends all paths in the queue by their nearest intersection,
+// shades them grouped by the kind of material they hit, gathers their shadow
+// connections and compacts the queue to the paths that continue. Each stage is a
+// parallel loop on the pool, the bounces themselves are the ones of PathIntegrator.
+class WavefrontIntegrator {
+
+public:
+  enum class Stage {GENERATE, EXTEND, SHADE, CONNECT, COMPACT};
+  static const unsigned int numberOfStages = 5;
+
+  WavefrontIntegrator(const Scene& scene,
+                      const PathIntegrator& integrator,
+                      const Camera& camera,
+                      ThreadPool& threadPool,
+                      const bool packetTracing,
+                      const Sampler& sampler);
+
+  // Mean radiance of numberOfSamples paths through each pixel, row by row from the top left. 
+  // The paths are added to aovs when given.
+  std::vector<glm::vec3> render(const unsigned int numberOfSamples, AovBuffer* aovs = nullptr);
+
+  // Time spent in stage over all calls to render()
+  unsigned long long getMicroseconds(const Stage stage) const { return microseconds_[static_cast<unsigned int>(stage)]; }
+
+  // Rays intersected by the extend stage, camera rays included. With packet tracing
+  // the camera rays are traced as packets, the incoherent rays after them one by one.
+  unsigned long long getExtendedRays() const { return extendedRays_; }
+
+protected:
+
+private:
+  // Paths of one batch, tiles are added until the next one would exceed this
+  static const unsigned int maxBatchSize_ = 1 << 18;
+
+  // Paths per work item of the stages
+  static const unsigned int chunkSize_ = 4096;
+
+  static const unsigned int tileSize_ = 8;
+
+  // Shading order, paths that hit the same kind of material are shaded together
+  enum Material {MISS, LIGHT, TRANSPARENT, OPAQUE, NUMBER_OF_MATERIALS};
+
+  // Paths still being traced, index i of every array belongs to the same path
+  struct PathQueue {
+    std::vector<unsigned int> paths; // Index of the path within the batch
+    std::vector<glm::vec3> origins;
+    std::vector<glm::vec3> directions;
+    std::vector<glm::vec3> throughputs;
+    std::vector<float> refractionIndices;
+    std::vector<unsigned int> depths;
+    std::vector<RandomSequence> sequences; // The random numbers of each path
+
+    void resize(const unsigned int size);
+
+    PathIntegrator::PathState load(const unsigned int index) const;
+    void store(const unsigned int index, const PathIntegrator::PathState& path);
+    void move(const unsigned int from, PathQueue& to, const unsigned int index) const;
+  };
+
+  const Scene& scene_;
+  const PathIntegrator& integrator_;
+  const Camera& camera_;
+  ThreadPool& threadPool_;
+  const bool packetTracing_;
+  const Sampler& sampler_;
+
+  PathQueue queue_;
+  PathQueue compacted_;
+  unsigned int queueSize_;
+
+  std::vector<std::pair<Object*, HitRecord>> intersections_;
+  std::vector<PathIntegrator::ShadowConnection> shadowConnections_;
+  std::vector<unsigned char> continues_;
+  std::vector<unsigned int> shadingOrder_;
+
+  // Per path of the batch
+  std::vector<unsigned int> pixels_;
+  std::vector<glm::vec3> radiance_;
+
+  // Per path of the batch for the AOVs, the radiance is kept from the first surface
+  std::vector<PathIntegrator::FirstSurface> surfaces_;
+  std::vector<glm::vec3> direct_;
+  std::vector<unsigned char> pastFirstSurface_;
+
+  unsigned long long microseconds_[numberOfStages];
+  unsigned long long extendedRays_;
+
+  void generate(const unsigned int firstTile, const unsigned int numberOfTiles, const unsigned int numberOfSamples);
+  void extend(const bool packets);
+  void shade();
+  void connect();
+  void compact();
+
+  // Calls work(chunk, first, count) for the chunks of chunkSize_ paths in [0, count) on the pool
+  template<typename Work>
+  void forEachChunk(const unsigned int count, Work work);
+
+  // Runs stageFunction() and adds the time it took to the stage
+  template<typename StageFunction>
+  void time(const Stage stage, StageFunction stageFunction);
+
+};
+
+
+template<typename Work>
+void WavefrontIntegrator::forEachChunk(const unsigned int count, Work work) {
+  threadPool_.parallelFor(0, count, chunkSize_, work);
+}
+
+
+template<typename StageFunction>
+void WavefrontIntegrator::time(const Stage stage, StageFunction stageFunction) {
+  const auto startTime = std::chrono::high_resolution_clock::now();
+  stageFunction();
+  const auto endTime = std::chrono::high_resolution_clock::now();
+  microseconds_[static_cast<unsigned int>(stage)] += std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count();
+}
+
+
+#endif // WAVEFRONTINTEGRATOR_H
@@ -0,0 +1,102 @@
+#ifndef BOUNDINGBOX_H
+#define BOUNDINGBOX_H
+
+#include <limits>
+#include <algorithm>
+
+#include "glm/glm.hpp"
+
+#include "Ray.h"
+
+
+class BoundingBox {
+
+public:
+  BoundingBox()
+  : min_{std::numeric_limits<float>::max()}
+  , max_{-std::numeric_limits<float>::max()}
+  {
+
+  }
+
+  BoundingBox(const glm::vec3& min, const glm::vec3& max)
+  : min_{min}
+  , max_{max}
+  {
+
+  }
+
+  glm::vec3 getMin() const { return min_; }
+  glm::vec3 getMax() const { return max_; }
+  glm::vec3 getCentroid() const { return 0.5f * (min_ + max_); }
+  glm::vec3 getExtent() const { return max_ - min_; }
+
+  bool isEmpty() const { 
+    return min_.x > max_.x || min_.y > max_.y || min_.z > max_.z; 
+  }
+
+  float getSurfaceArea() const {
+    if( isEmpty() ) {
+      return 0.0f;
+    }
+    const glm::vec3 extent = getExtent();
+    return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+  }
+
+  unsigned int getLongestAxis() const {
+    const glm::vec3 extent = getExtent();
+    if( extent.x > extent.y && extent.x > extent.z ) {
+      return 0;
+    }
+    return extent.y > extent.z ? 1 : 2;
+  }
+
+  void expand(const glm::vec3& point) {
+    min_ = glm::vec3{std::min(min_.x, point.x), std::min(min_.y, point.y), std::min(min_.z, point.z)};
+    max_ = glm::vec3{std::max(max_.x, point.x), std::max(max_.y, point.y), std::max(max_.z, point.z)};
+  }
+
+  // Empty boxes leave the box unchanged
+  void expand(const BoundingBox& box) {
+    if( box.isEmpty() ) {
+      return;
+    }
+    expand(box.min_);
+    expand(box.max_);
+  }
+
+  // Slab test, returns the entry distance in tNear when the box is hit before tMax.
+  bool intersect(const glm::vec3& origin, const glm::vec3& inversedDirection, const float tMax, float& tNear) const {
+    const float tx1 = (min_.x - origin.x) * inversedDirection.x;
+    const float tx2 = (max_.x - origin.x) * inversedDirection.x;
+
+    float sMin = std::min(tx1, tx2);
+    float sMax = std::max(tx1, tx2);
+
+    const float ty1 = (min_.y - origin.y) * inversedDirection.y;
+    const float ty2 = (max_.y - origin.y) * inversedDirection.y;
+
+    sMin = std::max(sMin, std::min(ty1, ty2));
+    sMax = std::min(sMax, std::max(ty1, ty2));
+
+    const float tz1 = (min_.z - origin.z) * inversedDirection.z;
+    const float tz2 = (max_.z - origin.z) * inversedDirection.z;
+
+    sMin = std::max(sMin, std::min(tz1, tz2));
+    sMax = std::min(sMax, std::max(tz1, tz2));
+
+    tNear = sMin;
+
+    return sMax >= std::max(sMin, 0.0f) && sMin < tMax;
+  }
+
+protected:
+
+private:
+  glm::vec3 min_;
+  glm::vec3 max_;
+
+};
+
+
+#endif // BOUNDINGBOX_H
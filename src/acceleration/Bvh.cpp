@@ -0,0 +1,584 @@
+#include "Bvh.h"
+
+#include "acceleration/BvhCache.h"
+
+
+unsigned int Bvh::preferredWidth_ = 0;
+float Bvh::rebuildThreshold_ = 1.5f;
+
+const unsigned int Bvh::binCount_;
+const unsigned int Bvh::parallelThreshold_;
+const unsigned int Bvh::chunkSize_;
+const unsigned int Bvh::chunkPriority_;
+const unsigned int Bvh::subtreePriority_;
+
+
+void Bvh::setPreferredWidth(const unsigned int width) {
+  preferredWidth_ = width;
+}
+
+
+unsigned int Bvh::getPreferredWidth() {
+  const unsigned int supportedWidth = getSupportedBvhWidth();
+  if( preferredWidth_ == 0 ) {
+    return supportedWidth;
+  }
+  // Fall back to the binary BVH when the requested width is not supported by the CPU
+  return (preferredWidth_ == 4 || preferredWidth_ == 8) && preferredWidth_ <= supportedWidth ? preferredWidth_ : 2;
+}
+
+
+void Bvh::build(const std::vector<BoundingBox>& primitiveBounds, ThreadPool* threadPool) {
+  nodes_.clear();
+  primitiveIndices_.clear();
+
+  if( !primitiveBounds.empty() ) {
+    const unsigned long long cacheKey = BvhCache::isEnabled() ? getCacheKey(primitiveBounds) : 0;
+    if( !BvhCache::load(cacheKey, primitiveBounds.size(), nodes_, primitiveIndices_) ) {
+      buildNodes(primitiveBounds, threadPool);
+      BvhCache::store(cacheKey, nodes_, primitiveIndices_);
+    }
+  }
+
+  sahCost_ = computeSahCost();
+  builtSahCost_ = sahCost_;
+
+  collapse();
+}
+
+
+bool Bvh::refit(const std::vector<BoundingBox>& primitiveBounds, ThreadPool* threadPool) {
+  if( primitiveBounds.size() != primitiveIndices_.size() ) {
+    throw std::invalid_argument{"Bvh::refit() needs the bounds of the same primitives as the last build."};
+  }
+
+  if( nodes_.empty() ) {
+    return false;
+  }
+
+  // Both children are stored after their parent, so walking the nodes 
+  // backwards updates every child before the parent that encloses it
+  for(unsigned int i=nodes_.size(); i-- > 0; ) {
+    BvhNode& node = nodes_[i];
+    BoundingBox bounds;
+    if( node.isLeaf() ) {
+      for(unsigned int p=node.offset; p<node.offset + node.count; p++) {
+        bounds.expand(primitiveBounds[primitiveIndices_[p]]);
+      }
+    } else {
+      bounds.expand(nodes_[i + 1].bounds);
+      bounds.expand(nodes_[node.offset].bounds);
+    }
+    node.bounds = bounds;
+  }
+
+  sahCost_ = computeSahCost();
+
+  // Refitted boxes only grow apart, once they overlap too much a new topology pays off
+  const bool rebuild = sahCost_ > rebuildThreshold_ * builtSahCost_;
+  if( rebuild ) {
+    nodes_.clear();
+    primitiveIndices_.clear();
+    buildNodes(primitiveBounds, threadPool);
+    sahCost_ = computeSahCost();
+    builtSahCost_ = sahCost_;
+  }
+
+  collapse();
+
+  return rebuild;
+}
+
+
+void Bvh::setRebuildThreshold(const float threshold) {
+  rebuildThreshold_ = threshold;
+}
+
+
+float Bvh::getRebuildThreshold() {
+  return rebuildThreshold_;
+}
+
+
+void Bvh::buildNodes(const std::vector<BoundingBox>& primitiveBounds, ThreadPool* threadPool) {
+  std::vector<glm::vec3> centroids;
+  centroids.reserve(primitiveBounds.size());
+  primitiveIndices_.reserve(primitiveBounds.size());
+
+  for(unsigned int i=0; i<primitiveBounds.size(); i++) {
+    centroids.push_back(primitiveBounds[i].getCentroid());
+    primitiveIndices_.push_back(i);
+  }
+
+  nodes_.reserve(2 * primitiveBounds.size());
+
+  if( threadPool && primitiveBounds.size() > parallelThreshold_ ) {
+    // The top levels reference the subtrees, which are spliced in depth first 
+    // order once all of them are built so that the layout matches a serial build
+    std::vector<BvhNode> topNodes;
+    std::deque<std::vector<BvhNode> > subtrees;
+    std::atomic<unsigned int> pendingSubtrees{0};
+    buildTopLevels(topNodes, subtrees, primitiveBounds, centroids, 0, primitiveBounds.size(), 0, threadPool, pendingSubtrees);
+    threadPool->wait(pendingSubtrees, subtreePriority_);
+    appendNodes(topNodes, subtrees, 0);
+  } else {
+    buildRecursive(nodes_, primitiveBounds, centroids, 0, primitiveBounds.size(), 0);
+  }
+
+  nodes_.shrink_to_fit();
+}
+
+
+float Bvh::computeSahCost() const {
+  if( nodes_.empty() ) {
+    return 0.0f;
+  }
+
+  const float rootArea = nodes_[0].bounds.getSurfaceArea();
+  if( rootArea <= 0.0f ) {
+    return 0.0f;
+  }
+
+  // Same unit costs as the builder, one per traversal step and one per primitive
+  double cost = 0.0;
+  for(unsigned int i=0; i<nodes_.size(); i++) {
+    const BvhNode& node = nodes_[i];
+    cost += node.bounds.getSurfaceArea() * (node.isLeaf() ? node.count : 1.0f);
+  }
+
+  return static_cast<float>(cost / rootArea);
+}
+
+
+unsigned long long Bvh::getCacheKey(const std::vector<BoundingBox>& primitiveBounds) const {
+  const unsigned int parameters[] = {builderVersion_, maxLeafSize_, binCount_, sweepThreshold_, 
+                                     static_cast<unsigned int>(primitiveBounds.size())};
+  const unsigned long long key = BvhCache::hash(parameters, sizeof(parameters));
+  return BvhCache::hash(primitiveBounds.data(), primitiveBounds.size() * sizeof(BoundingBox), key);
+}
+
+
+void Bvh::collapse() {
+  nodes4_.clear();
+  nodes8_.clear();
+  width_ = getPreferredWidth();
+
+  if( nodes_.empty() ) {
+    return;
+  }
+
+  if( width_ == 8 ) {
+    nodes8_.reserve(nodes_.size() / 4 + 1);
+    collapseRecursive(nodes8_, 0);
+  } else if( width_ == 4 ) {
+    nodes4_.reserve(nodes_.size() / 2 + 1);
+    collapseRecursive(nodes4_, 0);
+  }
+}
+
+
+template<unsigned int Width>
+unsigned int Bvh::collapseRecursive(std::vector<WideBvhNode<Width> >& wideNodes, const unsigned int index) const {
+  const unsigned int wideIndex = wideNodes.size();
+  wideNodes.push_back(WideBvhNode<Width>{});
+  wideNodes[wideIndex].clear();
+
+  // Pull grandchildren up into this node by repeatedly opening the 
+  // interior child with the largest surface area
+  unsigned int children[Width];
+  unsigned int numberOfChildren = 0;
+
+  if( nodes_[index].isLeaf() ) {
+    children[numberOfChildren++] = index;
+  } else {
+    children[numberOfChildren++] = index + 1;
+    children[numberOfChildren++] = nodes_[index].offset;
+  }
+
+  while( numberOfChildren < Width ) {
+    int largest = -1;
+    float largestArea = -1.0f;
+    for(unsigned int i=0; i<numberOfChildren; i++) {
+      const BvhNode& child = nodes_[children[i]];
+      if( !child.isLeaf() && child.bounds.getSurfaceArea() > largestArea ) {
+        largest = i;
+        largestArea = child.bounds.getSurfaceArea();
+      }
+    }
+
+    if( largest < 0 ) {
+      break;
+    }
+
+    const unsigned int opened = children[largest];
+    children[largest] = opened + 1;
+    children[numberOfChildren++] = nodes_[opened].offset;
+  }
+
+  for(unsigned int i=0; i<numberOfChildren; i++) {
+    const BvhNode& child = nodes_[children[i]];
+    wideNodes[wideIndex].setBounds(i, child.bounds);
+    wideNodes[wideIndex].occupied |= 1u << i;
+
+    if( child.isLeaf() ) {
+      wideNodes[wideIndex].child[i] = child.offset;
+      wideNodes[wideIndex].count[i] = child.count;
+    } else {
+      const unsigned int wideChild = collapseRecursive(wideNodes, children[i]);
+      wideNodes[wideIndex].child[i] = wideChild;
+      wideNodes[wideIndex].count[i] = 0;
+    }
+  }
+
+  return wideIndex;
+}
+
+
+unsigned int Bvh::buildRecursive(std::vector<BvhNode>& nodes,
+                                 const std::vector<BoundingBox>& primitiveBounds,
+                                 const std::vector<glm::vec3>& centroids,
+                                 const unsigned int first, 
+                                 const unsigned int count,
+                                 const unsigned int depth) {
+
+  const unsigned int index = nodes.size();
+  nodes.push_back(BvhNode{BoundingBox{}, first, count});
+
+  BoundingBox bounds;
+  BoundingBox centroidBounds;
+  computeBounds(primitiveBounds, centroids, first, count, bounds, centroidBounds, nullptr);
+  nodes[index].bounds = bounds;
+
+  if( count <= 1 || depth >= maxDepth_ ) {
+    return index;
+  }
+
+  const unsigned int split = count > sweepThreshold_ ? splitBinned(primitiveBounds, centroids, first, count, bounds, centroidBounds, nullptr)
+                                                     : splitSweep(primitiveBounds, centroids, first, count, bounds, centroidBounds);
+
+  if( split == 0 ) {
+    return index;
+  }
+
+  nodes[index].count = 0;
+  buildRecursive(nodes, primitiveBounds, centroids, first, split, depth + 1);
+  const unsigned int right = buildRecursive(nodes, primitiveBounds, centroids, first + split, count - split, depth + 1);
+  nodes[index].offset = right;
+
+  return index;
+}
+
+
+unsigned int Bvh::buildTopLevels(std::vector<BvhNode>& nodes,
+                                 std::deque<std::vector<BvhNode> >& subtrees,
+                                 const std::vector<BoundingBox>& primitiveBounds,
+                                 const std::vector<glm::vec3>& centroids,
+                                 const unsigned int first, 
+                                 const unsigned int count,
+                                 const unsigned int depth,
+                                 ThreadPool* threadPool,
+                                 std::atomic<unsigned int>& pendingSubtrees) {
+
+  const unsigned int index = nodes.size();
+
+  // Small enough to be built by a single worker
+  if( count <= parallelThreshold_ ) {
+    nodes.push_back(BvhNode{BoundingBox{}, static_cast<unsigned int>(subtrees.size()), subtreeMarker_});
+    subtrees.push_back(std::vector<BvhNode>{});
+    std::vector<BvhNode>* subtree = &subtrees.back();
+
+    pendingSubtrees++;
+    threadPool->add(new WorkItem([this, subtree, &primitiveBounds, &centroids, &pendingSubtrees, first, count, depth]() {
+      subtree->reserve(2 * count);
+      buildRecursive(*subtree, primitiveBounds, centroids, first, count, depth);
+      pendingSubtrees--;
+    }, subtreePriority_));
+
+    return index;
+  }
+
+  nodes.push_back(BvhNode{BoundingBox{}, first, count});
+
+  BoundingBox bounds;
+  BoundingBox centroidBounds;
+  computeBounds(primitiveBounds, centroids, first, count, bounds, centroidBounds, threadPool);
+  nodes[index].bounds = bounds;
+
+  if( depth >= maxDepth_ ) {
+    return index;
+  }
+
+  const unsigned int split = splitBinned(primitiveBounds, centroids, first, count, bounds, centroidBounds, threadPool);
+
+  if( split == 0 ) {
+    return index;
+  }
+
+  nodes[index].count = 0;
+  buildTopLevels(nodes, subtrees, primitiveBounds, centroids, first, split, depth + 1, threadPool, pendingSubtrees);
+  const unsigned int right = buildTopLevels(nodes, subtrees, primitiveBounds, centroids, first + split, count - split, depth + 1, threadPool, pendingSubtrees);
+  nodes[index].offset = right;
+
+  return index;
+}
+
+
+unsigned int Bvh::appendNodes(const std::vector<BvhNode>& topNodes, 
+                              const std::deque<std::vector<BvhNode> >& subtrees, 
+                              const unsigned int index) {
+  const BvhNode& node = topNodes[index];
+  const unsigned int nodeIndex = nodes_.size();
+
+  if( node.count == subtreeMarker_ ) {
+    for(const BvhNode& subtreeNode: subtrees[node.offset]) {
+      nodes_.push_back(subtreeNode);
+      if( !subtreeNode.isLeaf() ) {
+        nodes_.back().offset += nodeIndex;
+      }
+    }
+    return nodeIndex;
+  }
+
+  nodes_.push_back(node);
+
+  if( !node.isLeaf() ) {
+    appendNodes(topNodes, subtrees, index + 1);
+    nodes_[nodeIndex].offset = appendNodes(topNodes, subtrees, node.offset);
+  }
+
+  return nodeIndex;
+}
+
+
+void Bvh::computeBounds(const std::vector<BoundingBox>& primitiveBounds,
+                        const std::vector<glm::vec3>& centroids,
+                        const unsigned int first, 
+                        const unsigned int count,
+                        BoundingBox& bounds,
+                        BoundingBox& centroidBounds,
+                        ThreadPool* threadPool) const {
+
+  const unsigned int numberOfChunks = (count + chunkSize_ - 1) / chunkSize_;
+  std::vector<BoundingBox> chunkBounds(numberOfChunks);
+  std::vector<BoundingBox> chunkCentroidBounds(numberOfChunks);
+
+  forEachChunk(first, count, threadPool, [&](const unsigned int chunk, const unsigned int chunkFirst, const unsigned int chunkCount) {
+    for(unsigned int i=chunkFirst; i<chunkFirst + chunkCount; i++) {
+      chunkBounds[chunk].expand(primitiveBounds[primitiveIndices_[i]]);
+      chunkCentroidBounds[chunk].expand(centroids[primitiveIndices_[i]]);
+    }
+  });
+
+  for(unsigned int chunk=0; chunk<numberOfChunks; chunk++) {
+    bounds.expand(chunkBounds[chunk]);
+    centroidBounds.expand(chunkCentroidBounds[chunk]);
+  }
+}
+
+
+unsigned int Bvh::splitSweep(const std::vector<BoundingBox>& primitiveBounds,
+                             const std::vector<glm::vec3>& centroids,
+                             const unsigned int first, 
+                             const unsigned int count,
+                             const BoundingBox& bounds,
+                             const BoundingBox& centroidBounds) {
+
+  // Surface area heuristic, full sweep over the primitives sorted along each axis.
+  // Costs are relative to the cost of intersecting one primitive.
+  const float traversalCost = 1.0f;
+  const float leafCost = count;
+  const float inverseArea = 1.0f / std::max(bounds.getSurfaceArea(), std::numeric_limits<float>::min());
+
+  float bestCost = std::numeric_limits<float>::max();
+  unsigned int bestAxis = 0;
+  unsigned int bestSplit = 0;
+
+  std::vector<float> rightAreas(count);
+  const auto begin = primitiveIndices_.begin() + first;
+  const auto end = begin + count;
+
+  for(unsigned int axis=0; axis<3; axis++) {
+    if( centroidBounds.getExtent()[axis] <= 0.0f ) {
+      continue;
+    }
+
+    std::sort(begin, end, [&centroids, axis](const unsigned int a, const unsigned int b) {
+      return centroids[a][axis] < centroids[b][axis] || (centroids[a][axis] == centroids[b][axis] && a < b);
+    });
+
+    BoundingBox right;
+    for(unsigned int i=count-1; i>0; i--) {
+      right.expand(primitiveBounds[primitiveIndices_[first + i]]);
+      rightAreas[i] = right.getSurfaceArea();
+    }
+
+    BoundingBox left;
+    for(unsigned int i=1; i<count; i++) {
+      left.expand(primitiveBounds[primitiveIndices_[first + i - 1]]);
+      const float cost = traversalCost + (left.getSurfaceArea() * i + rightAreas[i] * (count - i)) * inverseArea;
+      if( cost < bestCost ) {
+        bestCost = cost;
+        bestAxis = axis;
+        bestSplit = i;
+      }
+    }
+  }
+
+  if( bestSplit == 0 || (bestCost >= leafCost && count <= maxLeafSize_) ) {
+    return 0;
+  }
+
+  std::sort(begin, end, [&centroids, bestAxis](const unsigned int a, const unsigned int b) {
+    return centroids[a][bestAxis] < centroids[b][bestAxis] || (centroids[a][bestAxis] == centroids[b][bestAxis] && a < b);
+  });
+
+  return bestSplit;
+}
+
+
+namespace {
+
+struct BvhBin {
+  BoundingBox bounds;
+  unsigned int count = 0;
+};
+
+}
+
+
+unsigned int Bvh::splitBinned(const std::vector<BoundingBox>& primitiveBounds,
+                              const std::vector<glm::vec3>& centroids,
+                              const unsigned int first, 
+                              const unsigned int count,
+                              const BoundingBox& bounds,
+                              const BoundingBox& centroidBounds,
+                              ThreadPool* threadPool) {
+
+  const glm::vec3 centroidMin = centroidBounds.getMin();
+  const glm::vec3 centroidExtent = centroidBounds.getExtent();
+
+  // Scaled slightly below binCount_ so that the largest centroid still lands in the last bin
+  glm::vec3 binScale{0.0f, 0.0f, 0.0f};
+  for(unsigned int axis=0; axis<3; axis++) {
+    if( centroidExtent[axis] > 0.0f ) {
+      binScale[axis] = binCount_ * (1.0f - 1.0e-6f) / centroidExtent[axis];
+    }
+  }
+
+  const auto binOf = [&centroids, &centroidMin, &binScale](const unsigned int primitive, const unsigned int axis) {
+    const unsigned int bin = static_cast<unsigned int>((centroids[primitive][axis] - centroidMin[axis]) * binScale[axis]);
+    return std::min(bin, binCount_ - 1);
+  };
+
+  // Every chunk fills its own bins, which are then merged in chunk order
+  const unsigned int numberOfChunks = (count + chunkSize_ - 1) / chunkSize_;
+  std::vector<BvhBin> chunkBins(numberOfChunks * 3 * binCount_);
+
+  forEachChunk(first, count, threadPool, [&](const unsigned int chunk, const unsigned int chunkFirst, const unsigned int chunkCount) {
+    BvhBin* bins = &chunkBins[chunk * 3 * binCount_];
+    for(unsigned int i=chunkFirst; i<chunkFirst + chunkCount; i++) {
+      const unsigned int primitive = primitiveIndices_[i];
+      for(unsigned int axis=0; axis<3; axis++) {
+        BvhBin& bin = bins[axis * binCount_ + binOf(primitive, axis)];
+        bin.bounds.expand(primitiveBounds[primitive]);
+        bin.count++;
+      }
+    }
+  });
+
+  BvhBin bins[3][binCount_];
+  for(unsigned int chunk=0; chunk<numberOfChunks; chunk++) {
+    for(unsigned int axis=0; axis<3; axis++) {
+      for(unsigned int b=0; b<binCount_; b++) {
+        const BvhBin& chunkBin = chunkBins[(chunk * 3 + axis) * binCount_ + b];
+        bins[axis][b].bounds.expand(chunkBin.bounds);
+        bins[axis][b].count += chunkBin.count;
+      }
+    }
+  }
+
+  // Same costs as the full sweep, evaluated at the bin boundaries
+  const float traversalCost = 1.0f;
+  const float leafCost = count;
+  const float inverseArea = 1.0f / std::max(bounds.getSurfaceArea(), std::numeric_limits<float>::min());
+
+  float bestCost = std::numeric_limits<float>::max();
+  unsigned int bestAxis = 0;
+  unsigned int bestBin = 0;
+
+  for(unsigned int axis=0; axis<3; axis++) {
+    if( centroidExtent[axis] <= 0.0f ) {
+      continue;
+    }
+
+    float rightAreas[binCount_];
+    unsigned int rightCounts[binCount_];
+    BoundingBox right;
+    unsigned int rightCount = 0;
+    for(unsigned int b=binCount_-1; b>0; b--) {
+      right.expand(bins[axis][b].bounds);
+      rightCount += bins[axis][b].count;
+      rightAreas[b] = right.getSurfaceArea();
+      rightCounts[b] = rightCount;
+    }
+
+    BoundingBox left;
+    unsigned int leftCount = 0;
+    for(unsigned int b=1; b<binCount_; b++) {
+      left.expand(bins[axis][b-1].bounds);
+      leftCount += bins[axis][b-1].count;
+      if( leftCount == 0 || rightCounts[b] == 0 ) {
+        continue;
+      }
+      const float cost = traversalCost + (left.getSurfaceArea() * leftCount + rightAreas[b] * rightCounts[b]) * inverseArea;
+      if( cost < bestCost ) {
+        bestCost = cost;
+        bestAxis = axis;
+        bestBin = b;
+      }
+    }
+  }
+
+  if( bestBin == 0 || (bestCost >= leafCost && count <= maxLeafSize_) ) {
+    return 0;
+  }
+
+  // Stable partition, every chunk counts its left primitives and then scatters 
+  // them to offsets that follow from the counts of the chunks before it
+  std::vector<unsigned int> leftCounts(numberOfChunks, 0);
+
+  forEachChunk(first, count, threadPool, [&](const unsigned int chunk, const unsigned int chunkFirst, const unsigned int chunkCount) {
+    for(unsigned int i=chunkFirst; i<chunkFirst + chunkCount; i++) {
+      if( binOf(primitiveIndices_[i], bestAxis) < bestBin ) {
+        leftCounts[chunk]++;
+      }
+    }
+  });
+
+  std::vector<unsigned int> leftOffsets(numberOfChunks);
+  std::vector<unsigned int> rightOffsets(numberOfChunks);
+  unsigned int split = 0;
+  for(unsigned int chunk=0; chunk<numberOfChunks; chunk++) {
+    leftOffsets[chunk] = split;
+    split += leftCounts[chunk];
+  }
+  for(unsigned int chunk=0, offset=split; chunk<numberOfChunks; chunk++) {
+    rightOffsets[chunk] = offset;
+    offset += std::min(chunkSize_, count - chunk * chunkSize_) - leftCounts[chunk];
+  }
+
+  std::vector<unsigned int> partitioned(count);
+
+  forEachChunk(first, count, threadPool, [&](const unsigned int chunk, const unsigned int chunkFirst, const unsigned int chunkCount) {
+    unsigned int left = leftOffsets[chunk];
+    unsigned int right = rightOffsets[chunk];
+    for(unsigned int i=chunkFirst; i<chunkFirst + chunkCount; i++) {
+      const unsigned int primitive = primitiveIndices_[i];
+      partitioned[binOf(primitive, bestAxis) < bestBin ? left++ : right++] = primitive;
+    }
+  });
+
+  std::copy(partitioned.begin(), partitioned.end(), primitiveIndices_.begin() + first);
+
+  return split;
+}
@@ -0,0 +1,612 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <bitset>
+#include <deque>
+#include <stdexcept>
+#include <atomic>
+
+#include "glm/glm.hpp"
+
+#include "Ray.h"
+#include "RayPacket.h"
+#include "acceleration/BoundingBox.h"
+#include "acceleration/WideBvh.h"
+#include "acceleration/BvhStatistics.h"
+
+#include "thread/ThreadPool.h"
+
+
+// Interior nodes keep their left child directly after themselves and store 
+// the index of the right child in offset. Leaves store the index of their 
+// first primitive in offset and the number of primitives in count.
+struct BvhNode {
+  BoundingBox bounds;
+  unsigned int offset;
+  unsigned int count;
+
+  bool isLeaf() const { return count > 0; }
+};
+
+
+class Bvh {
+
+public:
+  Bvh() = default;
+
+  // Nodes with more than sweepThreshold_ primitives are split with binned SAH, 
+  // smaller ones with a full SAH sweep. Given a thread pool, the binning and 
+  // partitioning of large nodes run in chunks on the pool and subtrees below 
+  // parallelThreshold_ are built as separate work items. The resulting tree 
+  // is the same with or without the pool and for any number of workers.
+  // Only waits for its own work items, so it may run inside a work item as well.
+  // With BvhCache enabled the binary nodes are loaded from the cache when it 
+  // holds a tree for the same primitive bounds and builder, and stored otherwise.
+  void build(const std::vector<BoundingBox>& primitiveBounds, ThreadPool* threadPool = nullptr);
+
+  // Recomputes the bounds of all nodes bottom up in O(n) after the primitives have 
+  // moved or deformed, keeping the topology. When the SAH cost has grown past 
+  // getRebuildThreshold() times the cost after the last build the tree is rebuilt 
+  // instead, which bypasses BvhCache and may reorder the primitives. Returns true 
+  // when it rebuilt.
+  bool refit(const std::vector<BoundingBox>& primitiveBounds, ThreadPool* threadPool = nullptr);
+
+  bool isEmpty() const { return nodes_.empty(); }
+
+  // Expected cost of a ray relative to intersecting one primitive, as used by the builder
+  float getSahCost() const { return sahCost_; }
+
+  BoundingBox getBounds() const { return nodes_.empty() ? BoundingBox{} : nodes_[0].bounds; }
+
+  const std::vector<BvhNode>& getNodes() const { return nodes_; }
+
+  const std::vector<unsigned int>& getPrimitiveIndices() const { return primitiveIndices_; }
+
+  // Width of the nodes used for traversal, 2 for the binary BVH or 4/8 for the collapsed ones
+  unsigned int getWidth() const { return width_; }
+
+  // Width used by BVHs built from now on, 0 picks the widest one the CPU supports
+  static void setPreferredWidth(const unsigned int width);
+  static unsigned int getPreferredWidth();
+
+  // Ratio between the SAH cost of a refitted tree and the one it was built with that triggers a rebuild
+  static void setRebuildThreshold(const float threshold);
+  static float getRebuildThreshold();
+
+  // Nearest hit traversal. The intersector is called as intersector(primitive, tMax) 
+  // and shall return true and shrink tMax when it finds a closer hit.
+  template<typename Intersector>
+  bool intersect(const Ray* ray, float& tMax, Intersector intersector) const;
+
+  // Any hit traversal. The tester is called as tester(primitive) and the
+  // traversal stops as soon as it returns true.
+  template<typename Tester>
+  bool occluded(const Ray* ray, const float tMax, Tester tester) const;
+
+  // Variants that hand whole leaves to the callback as ranges [first, first + count) 
+  // of getPrimitiveIndices(), for meshes that store their primitives in leaf order.
+  template<typename LeafIntersector>
+  bool intersectLeaves(const Ray* ray, float& tMax, LeafIntersector intersector) const;
+
+  template<typename LeafTester>
+  bool occludedLeaves(const Ray* ray, const float tMax, LeafTester tester) const;
+
+  // Nearest hit traversal of the rays in rayMask of a coherent packet over the 
+  // binary nodes, tMax holds one distance per ray. The intersector is called as intersector(primitive, rayMask, tMax) 
+  // and shall return the rays in rayMask for which it found a closer hit. Returns the 
+  // rays that hit anything. Once fewer than packetFallbackSize_ rays remain in a 
+  // subtree they continue as single rays.
+  template<typename PacketIntersector>
+  unsigned long long intersectPacket(const RayPacket& packet, const unsigned long long rayMask, float* tMax, PacketIntersector intersector) const;
+
+  // Variant that hands whole leaves to the callback as intersector(first, count, rayMask, tMax)
+  template<typename PacketLeafIntersector>
+  unsigned long long intersectPacketLeaves(const RayPacket& packet, const unsigned long long rayMask, float* tMax, PacketLeafIntersector intersector) const;
+
+protected:
+
+private:
+  // Bump when a change to the builder changes the trees it produces, 
+  // so that trees cached by the previous version are rebuilt
+  static const unsigned int builderVersion_ = 1;
+
+  static const unsigned int maxLeafSize_ = 4;
+  static const unsigned int maxDepth_ = 64;
+  static const unsigned int packetFallbackSize_ = 4;
+
+  static const unsigned int binCount_ = 32;
+  static const unsigned int sweepThreshold_ = 64;
+  static const unsigned int parallelThreshold_ = 1 << 16;
+  static const unsigned int chunkSize_ = 1 << 14;
+
+  // Chunks go ahead of subtrees on the pool since the top levels wait for them
+  static const unsigned int chunkPriority_ = 0;
+  static const unsigned int subtreePriority_ = 1;
+
+  // Marks a leaf of the top levels that stands in for a subtree built on the pool
+  static const unsigned int subtreeMarker_ = ~0u;
+
+  static unsigned int preferredWidth_;
+  static float rebuildThreshold_;
+
+  std::vector<BvhNode> nodes_;
+  std::vector<unsigned int> primitiveIndices_;
+
+  float sahCost_ = 0.0f;
+  float builtSahCost_ = 0.0f;
+
+  unsigned int width_ = 2;
+  std::vector<WideBvhNode<4> > nodes4_;
+  std::vector<WideBvhNode<8> > nodes8_;
+
+  void buildNodes(const std::vector<BoundingBox>& primitiveBounds, ThreadPool* threadPool);
+
+  float computeSahCost() const;
+
+  void collapse();
+
+  unsigned long long getCacheKey(const std::vector<BoundingBox>& primitiveBounds) const;
+
+  template<unsigned int Width>
+  unsigned int collapseRecursive(std::vector<WideBvhNode<Width> >& wideNodes, const unsigned int index) const;
+
+  template<typename LeafIntersector>
+  bool intersectBinary(const Ray* ray, float& tMax, LeafIntersector intersector, const unsigned int root = 0) const;
+
+  template<unsigned int Width, typename LeafIntersector>
+  bool intersectWide(const std::vector<WideBvhNode<Width> >& wideNodes, const Ray* ray, float& tMax, LeafIntersector intersector) const;
+
+  template<typename LeafTester>
+  bool occludedBinary(const Ray* ray, const float tMax, LeafTester tester) const;
+
+  template<unsigned int Width, typename LeafTester>
+  bool occludedWide(const std::vector<WideBvhNode<Width> >& wideNodes, const Ray* ray, const float tMax, LeafTester tester) const;
+
+  unsigned int buildRecursive(std::vector<BvhNode>& nodes,
+                              const std::vector<BoundingBox>& primitiveBounds,
+                              const std::vector<glm::vec3>& centroids,
+                              const unsigned int first, 
+                              const unsigned int count,
+                              const unsigned int depth);
+
+  unsigned int buildTopLevels(std::vector<BvhNode>& nodes,
+                              std::deque<std::vector<BvhNode> >& subtrees,
+                              const std::vector<BoundingBox>& primitiveBounds,
+                              const std::vector<glm::vec3>& centroids,
+                              const unsigned int first, 
+                              const unsigned int count,
+                              const unsigned int depth,
+                              ThreadPool* threadPool,
+                              std::atomic<unsigned int>& pendingSubtrees);
+
+  unsigned int appendNodes(const std::vector<BvhNode>& topNodes, 
+                           const std::deque<std::vector<BvhNode> >& subtrees, 
+                           const unsigned int index);
+
+  void computeBounds(const std::vector<BoundingBox>& primitiveBounds,
+                     const std::vector<glm::vec3>& centroids,
+                     const unsigned int first, 
+                     const unsigned int count,
+                     BoundingBox& bounds,
+                     BoundingBox& centroidBounds,
+                     ThreadPool* threadPool) const;
+
+  // Splits [first, first + count) and returns the number of primitives on the left side, 
+  // 0 if the node should become a leaf
+  unsigned int splitSweep(const std::vector<BoundingBox>& primitiveBounds,
+                          const std::vector<glm::vec3>& centroids,
+                          const unsigned int first, 
+                          const unsigned int count,
+                          const BoundingBox& bounds,
+                          const BoundingBox& centroidBounds);
+
+  unsigned int splitBinned(const std::vector<BoundingBox>& primitiveBounds,
+                           const std::vector<glm::vec3>& centroids,
+                           const unsigned int first, 
+                           const unsigned int count,
+                           const BoundingBox& bounds,
+                           const BoundingBox& centroidBounds,
+                           ThreadPool* threadPool);
+
+  // Calls work(chunk, first, count) for the chunks of chunkSize_ primitives, on the 
+  // pool when the range is larger than parallelThreshold_
+  template<typename Work>
+  void forEachChunk(const unsigned int first, const unsigned int count, ThreadPool* threadPool, Work work) const;
+
+};
+
+
+template<typename Work>
+void Bvh::forEachChunk(const unsigned int first, const unsigned int count, ThreadPool* threadPool, Work work) const {
+  // Only the chunks are waited for, the subtrees already on the pool keep building meanwhile
+  if( threadPool && count > parallelThreshold_ ) {
+    threadPool->parallelFor(first, count, chunkSize_, work, chunkPriority_);
+    return;
+  }
+
+  for(unsigned int chunk=0; chunk * chunkSize_ < count; chunk++) {
+    const unsigned int chunkFirst = first + chunk * chunkSize_;
+    work(chunk, chunkFirst, std::min(chunkSize_, first + count - chunkFirst));
+  }
+}
+
+
+template<typename Intersector>
+bool Bvh::intersect(const Ray* ray, float& tMax, Intersector intersector) const {
+  return intersectLeaves(ray, tMax, [&](const unsigned int first, const unsigned int count, float& t) {
+    bool hit = false;
+    for(unsigned int i=first; i<first + count; i++) {
+      if( intersector(primitiveIndices_[i], t) ) {
+        hit = true;
+      }
+    }
+    return hit;
+  });
+}
+
+
+template<typename Tester>
+bool Bvh::occluded(const Ray* ray, const float tMax, Tester tester) const {
+  return occludedLeaves(ray, tMax, [&](const unsigned int first, const unsigned int count) {
+    for(unsigned int i=first; i<first + count; i++) {
+      if( tester(primitiveIndices_[i]) ) {
+        return true;
+      }
+    }
+    return false;
+  });
+}
+
+
+template<typename LeafIntersector>
+bool Bvh::intersectLeaves(const Ray* ray, float& tMax, LeafIntersector intersector) const {
+  switch( width_ ) {
+    case 8:
+      return intersectWide<8>(nodes8_, ray, tMax, intersector);
+    case 4:
+      return intersectWide<4>(nodes4_, ray, tMax, intersector);
+    default:
+      return intersectBinary(ray, tMax, intersector);
+  }
+}
+
+
+template<typename LeafTester>
+bool Bvh::occludedLeaves(const Ray* ray, const float tMax, LeafTester tester) const {
+  switch( width_ ) {
+    case 8:
+      return occludedWide<8>(nodes8_, ray, tMax, tester);
+    case 4:
+      return occludedWide<4>(nodes4_, ray, tMax, tester);
+    default:
+      return occludedBinary(ray, tMax, tester);
+  }
+}
+
+
+template<typename PacketIntersector>
+unsigned long long Bvh::intersectPacket(const RayPacket& packet, const unsigned long long rayMask, float* tMax, PacketIntersector intersector) const {
+  return intersectPacketLeaves(packet, rayMask, tMax, [&](const unsigned int first, const unsigned int count, const unsigned long long leafRayMask, float* t) {
+    unsigned long long hits = 0;
+    for(unsigned int i=first; i<first + count; i++) {
+      hits |= intersector(primitiveIndices_[i], leafRayMask, t);
+    }
+    return hits;
+  });
+}
+
+
+template<typename PacketLeafIntersector>
+unsigned long long Bvh::intersectPacketLeaves(const RayPacket& packet, const unsigned long long rayMask, float* tMax, PacketLeafIntersector intersector) const {
+  if( nodes_.empty() || rayMask == 0 ) {
+    return 0;
+  }
+
+  const glm::vec3 direction = packet.getDirection();
+
+  unsigned long long hits = 0;
+
+  // Only shrinks when a leaf reports closer hits, a stale value merely culls less
+  float farthest = packet.getFarthest(tMax);
+
+  // Every node on the stack carries the rays that hit its parent
+  unsigned int stack[maxDepth_ + 1];
+  unsigned long long stackMasks[maxDepth_ + 1];
+  unsigned int stackPointer = 0;
+  stack[stackPointer] = 0;
+  stackMasks[stackPointer++] = rayMask;
+
+  unsigned long long steps = 0;
+
+  while( stackPointer > 0 ) {
+    --stackPointer;
+    steps++;
+    const unsigned int index = stack[stackPointer];
+    const BvhNode& node = nodes_[index];
+
+    unsigned long long nodeRayMask = stackMasks[stackPointer];
+
+    if( !packet.intersectFrustum(node.bounds, farthest) ) {
+      continue;
+    }
+
+    // The packet has diverged, trace what is left of it one ray at a time
+    if( std::bitset<RayPacket::maxSize>(nodeRayMask).count() < packetFallbackSize_ ) {
+      for(unsigned int i=0; i<packet.getSize(); i++) {
+        const unsigned long long bit = 1ull << i;
+        if( (nodeRayMask & bit) && intersectBinary(packet.getRay(i), tMax[i], [&](const unsigned int first, const unsigned int count, float&) {
+              return intersector(first, count, bit, tMax) != 0;
+            }, index) ) {
+          hits |= bit;
+        }
+      }
+      farthest = packet.getFarthest(tMax);
+      continue;
+    }
+
+    nodeRayMask = packet.intersect(node.bounds, nodeRayMask, tMax);
+    if( nodeRayMask == 0 ) {
+      continue;
+    }
+
+    if( node.isLeaf() ) {
+      const unsigned long long leafHits = intersector(node.offset, node.count, nodeRayMask, tMax);
+      if( leafHits ) {
+        hits |= leafHits;
+        farthest = packet.getFarthest(tMax);
+      }
+      continue;
+    }
+
+    const unsigned int left = index + 1;
+    const unsigned int right = node.offset;
+
+    // Push the child farther along the packet direction first
+    const bool leftFirst = glm::dot(nodes_[right].bounds.getCentroid() - nodes_[left].bounds.getCentroid(), direction) >= 0.0f;
+    stack[stackPointer] = leftFirst ? right : left;
+    stackMasks[stackPointer++] = nodeRayMask;
+    stack[stackPointer] = leftFirst ? left : right;
+    stackMasks[stackPointer++] = nodeRayMask;
+  }
+
+  BvhStatistics::addTraversalSteps(2, steps);
+
+  return hits;
+}
+
+
+template<typename LeafIntersector>
+bool Bvh::intersectBinary(const Ray* ray, float& tMax, LeafIntersector intersector, const unsigned int root) const {
+  if( nodes_.empty() ) {
+    return false;
+  }
+
+  const glm::vec3 origin = ray->getOrigin();
+  const glm::vec3 inversedDirection = ray->getInversedDirection();
+
+  bool hit = false;
+
+  float tRoot;
+  if( !nodes_[root].bounds.intersect(origin, inversedDirection, tMax, tRoot) ) {
+    return false;
+  }
+
+  // Every node on the stack has already passed its box test, 
+  // the entry distance is kept so that it can be culled when tMax shrinks
+  unsigned int stack[maxDepth_ + 1];
+  float stackDistances[maxDepth_ + 1];
+  unsigned int stackPointer = 0;
+  stack[stackPointer] = root;
+  stackDistances[stackPointer++] = tRoot;
+
+  unsigned long long steps = 0;
+
+  while( stackPointer > 0 ) {
+    --stackPointer;
+    if( stackDistances[stackPointer] >= tMax ) {
+      continue;
+    }
+
+    steps++;
+    const unsigned int index = stack[stackPointer];
+    const BvhNode& node = nodes_[index];
+
+    if( node.isLeaf() ) {
+      if( intersector(node.offset, node.count, tMax) ) {
+        hit = true;
+      }
+      continue;
+    }
+
+    const unsigned int left = index + 1;
+    const unsigned int right = node.offset;
+
+    float tLeft;
+    float tRight;
+    const bool hitLeft = nodes_[left].bounds.intersect(origin, inversedDirection, tMax, tLeft);
+    const bool hitRight = nodes_[right].bounds.intersect(origin, inversedDirection, tMax, tRight);
+
+    // Push the farther child first so that the nearer one is visited first
+    if( hitLeft && hitRight ) {
+      const bool leftFirst = tLeft < tRight;
+      stack[stackPointer] = leftFirst ? right : left;
+      stackDistances[stackPointer++] = leftFirst ? tRight : tLeft;
+      stack[stackPointer] = leftFirst ? left : right;
+      stackDistances[stackPointer++] = leftFirst ? tLeft : tRight;
+    } else if( hitLeft ) {
+      stack[stackPointer] = left;
+      stackDistances[stackPointer++] = tLeft;
+    } else if( hitRight ) {
+      stack[stackPointer] = right;
+      stackDistances[stackPointer++] = tRight;
+    }
+  }
+
+  BvhStatistics::addTraversalSteps(2, steps);
+
+  return hit;
+}
+
+
+template<unsigned int Width, typename LeafIntersector>
+bool Bvh::intersectWide(const std::vector<WideBvhNode<Width> >& wideNodes, const Ray* ray, float& tMax, LeafIntersector intersector) const {
+  if( wideNodes.empty() ) {
+    return false;
+  }
+
+  const glm::vec3 origin = ray->getOrigin();
+  const glm::vec3 inversedDirection = ray->getInversedDirection();
+
+  bool hit = false;
+
+  // Each visited node replaces itself with at most Width children
+  unsigned int stack[maxDepth_ * (Width - 1) + 1];
+  float stackDistances[maxDepth_ * (Width - 1) + 1];
+  unsigned int stackPointer = 0;
+  stack[stackPointer] = 0;
+  stackDistances[stackPointer++] = 0.0f;
+
+  unsigned long long steps = 0;
+
+  while( stackPointer > 0 ) {
+    --stackPointer;
+    if( stackDistances[stackPointer] >= tMax ) {
+      continue;
+    }
+
+    steps++;
+    const WideBvhNode<Width>& node = wideNodes[stack[stackPointer]];
+
+    float distances[Width];
+    const unsigned int mask = intersectChildren(node, origin, inversedDirection, tMax, distances);
+
+    // Leaves are intersected right away, interior children are sorted by 
+    // distance so that the nearest one ends up on top of the stack
+    unsigned int interior[Width];
+    unsigned int numberOfInterior = 0;
+
+    for(unsigned int i=0; i<Width; i++) {
+      if( !(mask & (1u << i)) ) {
+        continue;
+      }
+
+      if( node.count[i] > 0 ) {
+        if( distances[i] >= tMax ) {
+          continue;
+        }
+        if( intersector(node.child[i], node.count[i], tMax) ) {
+          hit = true;
+        }
+      } else {
+        unsigned int j = numberOfInterior++;
+        while( j > 0 && distances[interior[j-1]] < distances[i] ) {
+          interior[j] = interior[j-1];
+          j--;
+        }
+        interior[j] = i;
+      }
+    }
+
+    for(unsigned int j=0; j<numberOfInterior; j++) {
+      stack[stackPointer] = node.child[interior[j]];
+      stackDistances[stackPointer++] = distances[interior[j]];
+    }
+  }
+
+  BvhStatistics::addTraversalSteps(Width, steps);
+
+  return hit;
+}
+
+
+template<typename LeafTester>
+bool Bvh::occludedBinary(const Ray* ray, const float tMax, LeafTester tester) const {
+  if( nodes_.empty() ) {
+    return false;
+  }
+
+  const glm::vec3 origin = ray->getOrigin();
+  const glm::vec3 inversedDirection = ray->getInversedDirection();
+
+  unsigned int stack[maxDepth_ + 1];
+  unsigned int stackPointer = 0;
+  stack[stackPointer++] = 0;
+
+  unsigned long long steps = 0;
+
+  while( stackPointer > 0 ) {
+    const unsigned int index = stack[--stackPointer];
+    const BvhNode& node = nodes_[index];
+
+    steps++;
+    float tNear;
+    if( !node.bounds.intersect(origin, inversedDirection, tMax, tNear) ) {
+      continue;
+    }
+
+    if( node.isLeaf() ) {
+      if( tester(node.offset, node.count) ) {
+        BvhStatistics::addTraversalSteps(2, steps);
+        return true;
+      }
+      continue;
+    }
+
+    stack[stackPointer++] = node.offset;
+    stack[stackPointer++] = index + 1;
+  }
+
+  BvhStatistics::addTraversalSteps(2, steps);
+
+  return false;
+}
+
+
+template<unsigned int Width, typename LeafTester>
+bool Bvh::occludedWide(const std::vector<WideBvhNode<Width> >& wideNodes, const Ray* ray, const float tMax, LeafTester tester) const {
+  if( wideNodes.empty() ) {
+    return false;
+  }
+
+  const glm::vec3 origin = ray->getOrigin();
+  const glm::vec3 inversedDirection = ray->getInversedDirection();
+
+  unsigned int stack[maxDepth_ * (Width - 1) + 1];
+  unsigned int stackPointer = 0;
+  stack[stackPointer++] = 0;
+
+  unsigned long long steps = 0;
+
+  while( stackPointer > 0 ) {
+    const WideBvhNode<Width>& node = wideNodes[stack[--stackPointer]];
+
+    steps++;
+    float distances[Width];
+    const unsigned int mask = intersectChildren(node, origin, inversedDirection, tMax, distances);
+
+    for(unsigned int i=0; i<Width; i++) {
+      if( !(mask & (1u << i)) ) {
+        continue;
+      }
+
+      if( node.count[i] > 0 ) {
+        if( tester(node.child[i], node.count[i]) ) {
+          BvhStatistics::addTraversalSteps(Width, steps);
+          return true;
+        }
+      } else {
+        stack[stackPointer++] = node.child[i];
+      }
+    }
+  }
+
+  BvhStatistics::addTraversalSteps(Width, steps);
+
+  return false;
+}
+
+
+#endif // BVH_H
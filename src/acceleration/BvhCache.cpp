@@ -0,0 +1,206 @@
+#include "BvhCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iterator>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define BVH_CACHE_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+
+namespace {
+
+  struct BvhCacheHeader {
+    char magic[8];
+    unsigned int version;
+    unsigned int nodeSize;
+    unsigned long long key;
+    unsigned long long numberOfNodes;
+    unsigned long long numberOfPrimitiveIndices;
+  };
+
+  const char bvhCacheMagic[8] = {'M', 'C', 'R', 'T', 'B', 'V', 'H', '\0'};
+
+}
+
+
+std::string BvhCache::directory_;
+
+
+void BvhCache::setDirectory(const std::string& directory) {
+  directory_ = directory;
+}
+
+
+unsigned long long BvhCache::hash(const void* data, const std::size_t size, const unsigned long long seed) {
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  unsigned long long value = seed;
+  for(std::size_t i=0; i<size; i++) {
+    value ^= bytes[i];
+    value *= hashPrime_;
+  }
+  return value;
+}
+
+
+std::string BvhCache::getPath(const unsigned long long key) {
+  std::ostringstream os;
+  os << directory_ << "/" << std::hex << std::setw(16) << std::setfill('0') << key << ".bvh";
+  return os.str();
+}
+
+
+bool BvhCache::load(const unsigned long long key,
+                    const unsigned int numberOfPrimitives,
+                    std::vector<BvhNode>& nodes,
+                    std::vector<unsigned int>& primitiveIndices) {
+  if( !isEnabled() ) {
+    return false;
+  }
+
+  const std::string path = getPath(key);
+
+#ifdef BVH_CACHE_MMAP
+  const int file = open(path.c_str(), O_RDONLY);
+  if( file < 0 ) {
+    return false;
+  }
+
+  struct stat status;
+  if( fstat(file, &status) != 0 || status.st_size <= 0 ) {
+    close(file);
+    return false;
+  }
+
+  const std::size_t size = static_cast<std::size_t>(status.st_size);
+  void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+  close(file);
+
+  if( mapping == MAP_FAILED ) {
+    return false;
+  }
+
+  const bool loaded = parse(static_cast<const char*>(mapping), size, key, numberOfPrimitives, nodes, primitiveIndices);
+  munmap(mapping, size);
+  return loaded;
+#else
+  std::ifstream input{path.c_str(), std::ios::binary};
+  if( !input ) {
+    return false;
+  }
+
+  const std::vector<char> data{std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()};
+  return !data.empty() && parse(&data[0], data.size(), key, numberOfPrimitives, nodes, primitiveIndices);
+#endif
+}
+
+
+bool BvhCache::store(const unsigned long long key,
+                     const std::vector<BvhNode>& nodes,
+                     const std::vector<unsigned int>& primitiveIndices) {
+  if( !isEnabled() ) {
+    return false;
+  }
+
+#ifdef BVH_CACHE_MMAP
+  mkdir(directory_.c_str(), 0755);
+#endif
+
+  BvhCacheHeader header;
+  std::memcpy(header.magic, bvhCacheMagic, sizeof(header.magic));
+  header.version = version_;
+  header.nodeSize = sizeof(BvhNode);
+  header.key = key;
+  header.numberOfNodes = nodes.size();
+  header.numberOfPrimitiveIndices = primitiveIndices.size();
+
+  // Written next to the final file and renamed into place, so that
+  // a concurrent run never reads a partially written file
+  const std::string path = getPath(key);
+  const std::string temporaryPath = path + ".tmp";
+
+  {
+    std::ofstream output{temporaryPath.c_str(), std::ios::binary | std::ios::trunc};
+    if( !output ) {
+      return false;
+    }
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    output.write(reinterpret_cast<const char*>(nodes.data()), nodes.size() * sizeof(BvhNode));
+    output.write(reinterpret_cast<const char*>(primitiveIndices.data()), primitiveIndices.size() * sizeof(unsigned int));
+    if( !output ) {
+      std::remove(temporaryPath.c_str());
+      return false;
+    }
+  }
+
+  std::remove(path.c_str());
+  if( std::rename(temporaryPath.c_str(), path.c_str()) != 0 ) {
+    std::remove(temporaryPath.c_str());
+    return false;
+  }
+  return true;
+}
+
+
+bool BvhCache::parse(const char* data,
+                     const std::size_t size,
+                     const unsigned long long key,
+                     const unsigned int numberOfPrimitives,
+                     std::vector<BvhNode>& nodes,
+                     std::vector<unsigned int>& primitiveIndices) {
+  BvhCacheHeader header;
+  if( size < sizeof(header) ) {
+    return false;
+  }
+  std::memcpy(&header, data, sizeof(header));
+
+  if( std::memcmp(header.magic, bvhCacheMagic, sizeof(header.magic)) != 0 ||
+      header.version != version_ ||
+      header.nodeSize != sizeof(BvhNode) ||
+      header.key != key ||
+      header.numberOfPrimitiveIndices != numberOfPrimitives ||
+      header.numberOfNodes == 0 ||
+      header.numberOfNodes > 2ull * numberOfPrimitives ) {
+    return false;
+  }
+
+  const std::size_t nodeBytes = header.numberOfNodes * sizeof(BvhNode);
+  const std::size_t indexBytes = header.numberOfPrimitiveIndices * sizeof(unsigned int);
+  if( size != sizeof(header) + nodeBytes + indexBytes ) {
+    return false;
+  }
+
+  nodes.resize(header.numberOfNodes);
+  primitiveIndices.resize(header.numberOfPrimitiveIndices);
+  std::memcpy(nodes.data(), data + sizeof(header), nodeBytes);
+  std::memcpy(primitiveIndices.data(), data + sizeof(header) + nodeBytes, indexBytes);
+
+  // A damaged file must not send the traversal out of bounds
+  for(unsigned int i=0; i<nodes.size(); i++) {
+    const BvhNode& node = nodes[i];
+    const bool valid = node.isLeaf() ? node.offset <= numberOfPrimitives && node.count <= numberOfPrimitives - node.offset
+                                     : i + 1 < nodes.size() && node.offset > i + 1 && node.offset < nodes.size();
+    if( !valid ) {
+      nodes.clear();
+      primitiveIndices.clear();
+      return false;
+    }
+  }
+  for(unsigned int i=0; i<primitiveIndices.size(); i++) {
+    if( primitiveIndices[i] >= numberOfPrimitives ) {
+      nodes.clear();
+      primitiveIndices.clear();
+      return false;
+    }
+  }
+
+  return true;
+}
@@ -0,0 +1,59 @@
+#ifndef BVHCACHE_H
+#define BVHCACHE_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#include "acceleration/Bvh.h"
+
+
+// Keeps built BVHs on disk between runs, one file per key in the cache directory.
+// A file holds a header with the format version and the key, followed by the
+// binary nodes and the reordered primitive indices. Files written by another
+// version of the format or for another key are ignored and overwritten.
+class BvhCache {
+
+public:
+  // An empty directory disables the cache
+  static void setDirectory(const std::string& directory);
+  static const std::string& getDirectory() { return directory_; }
+  static bool isEnabled() { return !directory_.empty(); }
+
+  // 64 bit FNV-1a, pass the previous hash as seed to hash several buffers
+  static unsigned long long hash(const void* data, const std::size_t size, const unsigned long long seed = hashOffset_);
+
+  // Returns false when there is no valid file for the key
+  static bool load(const unsigned long long key,
+                   const unsigned int numberOfPrimitives,
+                   std::vector<BvhNode>& nodes,
+                   std::vector<unsigned int>& primitiveIndices);
+
+  static bool store(const unsigned long long key,
+                    const std::vector<BvhNode>& nodes,
+                    const std::vector<unsigned int>& primitiveIndices);
+
+protected:
+
+private:
+  // Bump when the layout of the files changes
+  static const unsigned int version_ = 1;
+
+  static const unsigned long long hashOffset_ = 14695981039346656037ull;
+  static const unsigned long long hashPrime_ = 1099511628211ull;
+
+  static std::string directory_;
+
+  static std::string getPath(const unsigned long long key);
+
+  static bool parse(const char* data,
+                    const std::size_t size,
+                    const unsigned long long key,
+                    const unsigned int numberOfPrimitives,
+                    std::vector<BvhNode>& nodes,
+                    std::vector<unsigned int>& primitiveIndices);
+
+};
+
+
+#endif // BVHCACHE_H
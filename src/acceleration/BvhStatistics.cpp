@@ -0,0 +1,8 @@
+#include "BvhStatistics.h"
+
+const unsigned int BvhStatistics::numberOfWidths;
+
+#ifdef BVH_STATISTICS
+std::atomic<unsigned long long> BvhStatistics::rays_[numberOfWidths] = {};
+std::atomic<unsigned long long> BvhStatistics::traversalSteps_[numberOfWidths] = {};
+#endif
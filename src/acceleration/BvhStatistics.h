@@ -0,0 +1,47 @@
+#ifndef BVHSTATISTICS_H
+#define BVHSTATISTICS_H
+
+#include <atomic>
+
+
+// Traversal counters, only collected when compiled with -DBVH_STATISTICS 
+// since the shared counters would otherwise slow down every traversal.
+// Rays and steps are counted per width of the nodes they traverse, 2, 4 or 8.
+class BvhStatistics {
+
+public:
+  static const unsigned int numberOfWidths = 3;
+
+  // Width counted at index, 2, 4 and 8
+  static unsigned int getWidth(const unsigned int index) { return 2u << index; }
+
+#ifdef BVH_STATISTICS
+  static void addRay(const unsigned int width) { rays_[getIndex(width)].fetch_add(1, std::memory_order_relaxed); }
+  static void addTraversalSteps(const unsigned int width, const unsigned long long steps) { traversalSteps_[getIndex(width)].fetch_add(steps, std::memory_order_relaxed); }
+
+  static bool isEnabled() { return true; }
+  static unsigned long long getRays(const unsigned int width) { return rays_[getIndex(width)].load(); }
+  static unsigned long long getTraversalSteps(const unsigned int width) { return traversalSteps_[getIndex(width)].load(); }
+#else
+  static void addRay(const unsigned int) {}
+  static void addTraversalSteps(const unsigned int, const unsigned long long) {}
+
+  static bool isEnabled() { return false; }
+  static unsigned long long getRays(const unsigned int) { return 0; }
+  static unsigned long long getTraversalSteps(const unsigned int) { return 0; }
+#endif
+
+protected:
+
+private:
+#ifdef BVH_STATISTICS
+  static std::atomic<unsigned long long> rays_[numberOfWidths];
+  static std::atomic<unsigned long long> traversalSteps_[numberOfWidths];
+
+  static unsigned int getIndex(const unsigned int width) { return width >= 8 ? 2 : width / 4; }
+#endif
+
+};
+
+
+#endif // BVHSTATISTICS_H
@@ -0,0 +1,175 @@
+#include "LightBvh.h"
+
+
+constexpr float LightBvh::emissionAngle_;
+
+
+void LightBvh::build(const std::vector<Object*>& lights, const std::vector<float>& powers) {
+  nodes_.clear();
+
+  if( lights.empty() ) {
+    return;
+  }
+
+  std::vector<Node> leaves(lights.size());
+  std::vector<unsigned int> order(lights.size());
+
+  for(unsigned int i=0; i<lights.size(); i++) {
+    leaves[i].bounds = lights[i]->getBounds();
+    leaves[i].normalAngle = lights[i]->getNormalCone(leaves[i].axis);
+    leaves[i].power = powers[i];
+    leaves[i].secondChild = 0;
+    leaves[i].light = i;
+    leaves[i].isLeaf = true;
+    order[i] = i;
+  }
+
+  nodes_.reserve(2 * lights.size() - 1);
+  buildNode(leaves, order, 0, lights.size());
+}
+
+
+unsigned int LightBvh::buildNode(const std::vector<Node>& leaves, std::vector<unsigned int>& order, const unsigned int first, const unsigned int count) {
+  const unsigned int index = nodes_.size();
+
+  if( count == 1 ) {
+    nodes_.push_back(leaves[order[first]]);
+    return index;
+  }
+
+  nodes_.push_back(Node{});
+
+  // Median split along the longest axis of the centroids keeps the tree balanced
+  BoundingBox centroidBounds;
+  for(unsigned int i=first; i<first + count; i++) {
+    centroidBounds.expand(leaves[order[i]].bounds.getCentroid());
+  }
+  const unsigned int axis = centroidBounds.getLongestAxis();
+  const unsigned int middle = first + count / 2;
+
+  std::nth_element(order.begin() + first, order.begin() + middle, order.begin() + first + count, [&](const unsigned int a, const unsigned int b) {
+    return leaves[a].bounds.getCentroid()[axis] < leaves[b].bounds.getCentroid()[axis];
+  });
+
+  buildNode(leaves, order, first, middle - first);
+  const unsigned int secondChild = buildNode(leaves, order, middle, first + count - middle);
+
+  nodes_[index] = merge(nodes_[index + 1], nodes_[secondChild]);
+  nodes_[index].secondChild = secondChild;
+
+  return index;
+}
+
+
+bool LightBvh::sample(const glm::vec3& point, const glm::vec3& normal, float u, unsigned int& light, float& probability) const {
+  if( nodes_.empty() ) {
+    return false;
+  }
+
+  unsigned int index = 0;
+  probability = 1.0f;
+
+  while( !nodes_[index].isLeaf ) {
+    const unsigned int firstChild = index + 1;
+    const unsigned int secondChild = nodes_[index].secondChild;
+
+    const float firstImportance = getImportance(nodes_[firstChild], point, normal);
+    const float secondImportance = getImportance(nodes_[secondChild], point, normal);
+
+    if( firstImportance + secondImportance <= 0.0f ) {
+      return false;
+    }
+
+    // u is reused for the next level, rescaled to the interval of the child it picked
+    const float firstProbability = firstImportance / (firstImportance + secondImportance);
+
+    if( u < firstProbability ) {
+      u /= firstProbability;
+      probability *= firstProbability;
+      index = firstChild;
+    } else {
+      u = (u - firstProbability) / (1.0f - firstProbability);
+      probability *= 1.0f - firstProbability;
+      index = secondChild;
+    }
+
+    u = std::min(u, 0.99999994f);
+  }
+
+  light = nodes_[index].light;
+  return true;
+}
+
+
+float LightBvh::getImportance(const Node& node, const glm::vec3& point, const glm::vec3& normal) const {
+  const glm::vec3 toPoint = point - node.bounds.getCentroid();
+  const float distance2 = glm::dot(toPoint, toPoint);
+  const float radius = 0.5f * glm::length(node.bounds.getExtent());
+
+  // Closer than the bounding sphere, no direction can be ruled out
+  if( distance2 <= radius * radius ) {
+    return node.power / std::max(radius * radius, 1e-12f);
+  }
+
+  const float distance = std::sqrt(distance2);
+
+  // Smallest angle between a normal in the cone and a direction from the bounds to the point
+  const float angle = std::acos(clamp(glm::dot(node.axis, toPoint) / distance, -1.0f, 1.0f));
+  const float boundsAngle = std::asin(radius / distance);
+  const float reducedAngle = std::max(0.0f, angle - node.normalAngle - boundsAngle);
+
+  if( reducedAngle >= emissionAngle_ ) {
+    return 0.0f;
+  }
+
+  // Smallest angle between the normal at the point and a direction from the point to the bounds
+  const float receiverAngle = std::acos(clamp(-glm::dot(normal, toPoint) / distance, -1.0f, 1.0f));
+  const float reducedReceiverAngle = std::max(0.0f, receiverAngle - boundsAngle);
+
+  if( reducedReceiverAngle >= M_PI / 2.0f ) {
+    return 0.0f;
+  }
+
+  return node.power * std::cos(reducedAngle) * std::cos(reducedReceiverAngle) / distance2;
+}
+
+
+LightBvh::Node LightBvh::merge(const Node& a, const Node& b) {
+  Node node;
+  node.bounds = a.bounds;
+  node.bounds.expand(b.bounds);
+  node.power = a.power + b.power;
+  node.secondChild = 0;
+  node.light = 0;
+  node.isLeaf = false;
+
+  // Smallest cone holding both cones
+  const float between = std::acos(clamp(glm::dot(a.axis, b.axis), -1.0f, 1.0f));
+
+  if( std::min(between + b.normalAngle, (float)M_PI) <= a.normalAngle ) {
+    node.axis = a.axis;
+    node.normalAngle = a.normalAngle;
+    return node;
+  }
+
+  if( std::min(between + a.normalAngle, (float)M_PI) <= b.normalAngle ) {
+    node.axis = b.axis;
+    node.normalAngle = b.normalAngle;
+    return node;
+  }
+
+  const float normalAngle = 0.5f * (a.normalAngle + between + b.normalAngle);
+  const glm::vec3 rotationAxis = glm::cross(a.axis, b.axis);
+
+  if( normalAngle >= M_PI || glm::dot(rotationAxis, rotationAxis) == 0.0f ) {
+    node.axis = a.axis;
+    node.normalAngle = M_PI;
+    return node;
+  }
+
+  // Rotates the axis of a towards b until the cone reaches around both
+  const float rotation = normalAngle - a.normalAngle;
+  node.axis = std::cos(rotation) * a.axis + std::sin(rotation) * glm::cross(glm::normalize(rotationAxis), a.axis);
+  node.normalAngle = normalAngle;
+  return node;
+}
@@ -0,0 +1,64 @@
+#ifndef LIGHTBVH_H
+#define LIGHTBVH_H
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include "glm/glm.hpp"
+
+#include "acceleration/BoundingBox.h"
+
+#include "objects/Object.h"
+
+#include "utils/math.h"
+
+
+// Binary hierarchy over the lights of a scene for picking a light per shading point. 
+// Every node bounds the positions of its lights, the cone holding their normals and 
+// their total power. Sampling walks from the root and picks a child in proportion to 
+// an upper bound of the light it can send to the point, so nearby lights facing the 
+// point are picked more often than far away ones or ones facing away. Lights below 
+// the surface at the point, which it can not receive light from, are never picked.
+class LightBvh {
+
+public:
+  LightBvh() = default;
+
+  // powers[i] is the power emitted by lights[i]
+  void build(const std::vector<Object*>& lights, const std::vector<float>& powers);
+
+  // Picks the index of a light for point on a surface with normal, with u uniform in [0, 1), 
+  // and the probability of the pick. Returns false when no light can reach the point.
+  bool sample(const glm::vec3& point, const glm::vec3& normal, float u, unsigned int& light, float& probability) const;
+
+protected:
+
+private:
+  struct Node {
+    BoundingBox bounds;
+    glm::vec3 axis;
+    float normalAngle; // Half angle of the normal cone around axis
+    float power;
+    unsigned int secondChild; // The first child follows its parent
+    unsigned int light;
+    bool isLeaf;
+  };
+
+  // Lights emit up to this angle from their normals
+  static constexpr float emissionAngle_ = M_PI / 2.0f;
+
+  std::vector<Node> nodes_;
+
+  unsigned int buildNode(const std::vector<Node>& leaves, std::vector<unsigned int>& order, const unsigned int first, const unsigned int count);
+
+  // Upper bound of the light the lights of node can send to point on a surface with normal
+  float getImportance(const Node& node, const glm::vec3& point, const glm::vec3& normal) const;
+
+  // Node bounding the lights of both nodes
+  static Node merge(const Node& a, const Node& b);
+
+};
+
+
+#endif // LIGHTBVH_H
@@ -0,0 +1,221 @@
+#include "TriangleBlock.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TRIANGLE_BLOCK_SIMD
+#include <immintrin.h>
+#endif
+
+
+const unsigned int TriangleBlock::width;
+
+static const float triangleEpsilon = 0.000001f;
+
+
+void TriangleBlock::clear() {
+  for(unsigned int i=0; i<width; i++) {
+    v0x[i] = v0y[i] = v0z[i] = 0.0f;
+    e1x[i] = e1y[i] = e1z[i] = 0.0f;
+    e2x[i] = e2y[i] = e2z[i] = 0.0f;
+    triangles[i] = 0;
+  }
+}
+
+
+void TriangleBlock::set(const unsigned int lane, const unsigned int triangle, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2) {
+  const glm::vec3 e1 = v1 - v0;
+  const glm::vec3 e2 = v2 - v0;
+
+  v0x[lane] = v0.x;
+  v0y[lane] = v0.y;
+  v0z[lane] = v0.z;
+  e1x[lane] = e1.x;
+  e1y[lane] = e1.y;
+  e1z[lane] = e1.z;
+  e2x[lane] = e2.x;
+  e2y[lane] = e2.y;
+  e2z[lane] = e2.z;
+  triangles[lane] = triangle;
+}
+
+
+// Picks the nearest of the lanes in hitMask, the lowest lane wins ties so
+// that the result does not depend on the kernel used.
+static bool selectNearestLane(const unsigned int hitMask,
+                              const float* t,
+                              const float* u,
+                              const float* v,
+                              float& tMax,
+                              unsigned int& lane,
+                              glm::vec2& barycentrics) {
+  bool hit = false;
+  for(unsigned int i=0; i<TriangleBlock::width; i++) {
+    if( (hitMask & (1u << i)) && t[i] < tMax ) {
+      tMax = t[i];
+      lane = i;
+      barycentrics = glm::vec2{u[i], v[i]};
+      hit = true;
+    }
+  }
+  return hit;
+}
+
+
+bool intersectTriangleBlockReference(const TriangleBlock& block,
+                                     const unsigned int laneMask,
+                                     const glm::vec3& origin,
+                                     const glm::vec3& direction,
+                                     float& tMax,
+                                     unsigned int& lane,
+                                     glm::vec2& barycentrics) {
+  float t[TriangleBlock::width];
+  float u[TriangleBlock::width];
+  float v[TriangleBlock::width];
+  unsigned int hitMask = 0;
+
+  for(unsigned int i=0; i<TriangleBlock::width; i++) {
+    if( !(laneMask & (1u << i)) ) {
+      continue;
+    }
+
+    // P = D x e2
+    const float px = direction.y * block.e2z[i] - block.e2y[i] * direction.z;
+    const float py = direction.z * block.e2x[i] - block.e2z[i] * direction.x;
+    const float pz = direction.x * block.e2y[i] - block.e2x[i] * direction.y;
+
+    // If determinant is near zero, ray lies in plane of triangle
+    const float det = (block.e1x[i] * px + block.e1y[i] * py) + block.e1z[i] * pz;
+    if( !(det <= -triangleEpsilon || det >= triangleEpsilon) ) {
+      continue;
+    }
+    const float inverseDet = 1.0f / det;
+
+    // T = O - v0
+    const float tx = origin.x - block.v0x[i];
+    const float ty = origin.y - block.v0y[i];
+    const float tz = origin.z - block.v0z[i];
+
+    u[i] = ((tx * px + ty * py) + tz * pz) * inverseDet;
+    if( !(u[i] >= 0.0f && u[i] <= 1.0f) ) {
+      continue;
+    }
+
+    // Q = T x e1
+    const float qx = ty * block.e1z[i] - block.e1y[i] * tz;
+    const float qy = tz * block.e1x[i] - block.e1z[i] * tx;
+    const float qz = tx * block.e1y[i] - block.e1x[i] * ty;
+
+    v[i] = ((direction.x * qx + direction.y * qy) + direction.z * qz) * inverseDet;
+    if( !(v[i] >= 0.0f && u[i] + v[i] <= 1.0f) ) {
+      continue;
+    }
+
+    t[i] = ((block.e2x[i] * qx + block.e2y[i] * qy) + block.e2z[i] * qz) * inverseDet;
+    if( t[i] > triangleEpsilon ) {
+      hitMask |= 1u << i;
+    }
+  }
+
+  return selectNearestLane(hitMask, t, u, v, tMax, lane, barycentrics);
+}
+
+
+#ifdef TRIANGLE_BLOCK_SIMD
+
+static bool intersectTriangleBlockSse(const TriangleBlock& block,
+                                      const unsigned int laneMask,
+                                      const glm::vec3& origin,
+                                      const glm::vec3& direction,
+                                      float& tMax,
+                                      unsigned int& lane,
+                                      glm::vec2& barycentrics) {
+  const __m128 dx = _mm_set1_ps(direction.x);
+  const __m128 dy = _mm_set1_ps(direction.y);
+  const __m128 dz = _mm_set1_ps(direction.z);
+
+  const __m128 e1x = _mm_loadu_ps(block.e1x);
+  const __m128 e1y = _mm_loadu_ps(block.e1y);
+  const __m128 e1z = _mm_loadu_ps(block.e1z);
+  const __m128 e2x = _mm_loadu_ps(block.e2x);
+  const __m128 e2y = _mm_loadu_ps(block.e2y);
+  const __m128 e2z = _mm_loadu_ps(block.e2z);
+
+  const __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(e2y, dz));
+  const __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(e2z, dx));
+  const __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(e2x, dy));
+
+  const __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+  const __m128 epsilon = _mm_set1_ps(triangleEpsilon);
+  __m128 valid = _mm_or_ps(_mm_cmple_ps(det, _mm_set1_ps(-triangleEpsilon)), _mm_cmpge_ps(det, epsilon));
+  const __m128 inverseDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+
+  const __m128 tx = _mm_sub_ps(_mm_set1_ps(origin.x), _mm_loadu_ps(block.v0x));
+  const __m128 ty = _mm_sub_ps(_mm_set1_ps(origin.y), _mm_loadu_ps(block.v0y));
+  const __m128 tz = _mm_sub_ps(_mm_set1_ps(origin.z), _mm_loadu_ps(block.v0z));
+
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+
+  const __m128 uu = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, px), _mm_mul_ps(ty, py)), _mm_mul_ps(tz, pz)), inverseDet);
+  valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(uu, zero), _mm_cmple_ps(uu, one)));
+
+  const __m128 qx = _mm_sub_ps(_mm_mul_ps(ty, e1z), _mm_mul_ps(e1y, tz));
+  const __m128 qy = _mm_sub_ps(_mm_mul_ps(tz, e1x), _mm_mul_ps(e1z, tx));
+  const __m128 qz = _mm_sub_ps(_mm_mul_ps(tx, e1y), _mm_mul_ps(e1x, ty));
+
+  const __m128 vv = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), inverseDet);
+  valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(vv, zero), _mm_cmple_ps(_mm_add_ps(uu, vv), one)));
+
+  const __m128 tt = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inverseDet);
+  valid = _mm_and_ps(valid, _mm_cmpgt_ps(tt, epsilon));
+
+  const unsigned int hitMask = static_cast<unsigned int>(_mm_movemask_ps(valid)) & laneMask;
+  if( !hitMask ) {
+    return false;
+  }
+
+  float t[TriangleBlock::width];
+  float u[TriangleBlock::width];
+  float v[TriangleBlock::width];
+  _mm_storeu_ps(t, tt);
+  _mm_storeu_ps(u, uu);
+  _mm_storeu_ps(v, vv);
+
+  return selectNearestLane(hitMask, t, u, v, tMax, lane, barycentrics);
+}
+
+
+typedef bool (*TriangleBlockIntersector)(const TriangleBlock&, const unsigned int, const glm::vec3&, const glm::vec3&, float&, unsigned int&, glm::vec2&);
+
+static TriangleBlockIntersector selectTriangleBlockIntersector() {
+  __builtin_cpu_init();
+  if( __builtin_cpu_supports("sse2") ) {
+    return intersectTriangleBlockSse;
+  }
+  return intersectTriangleBlockReference;
+}
+
+
+bool intersectTriangleBlock(const TriangleBlock& block,
+                            const unsigned int laneMask,
+                            const glm::vec3& origin,
+                            const glm::vec3& direction,
+                            float& tMax,
+                            unsigned int& lane,
+                            glm::vec2& barycentrics) {
+  static const TriangleBlockIntersector intersector = selectTriangleBlockIntersector();
+  return intersector(block, laneMask, origin, direction, tMax, lane, barycentrics);
+}
+
+#else
+
+bool intersectTriangleBlock(const TriangleBlock& block,
+                            const unsigned int laneMask,
+                            const glm::vec3& origin,
+                            const glm::vec3& direction,
+                            float& tMax,
+                            unsigned int& lane,
+                            glm::vec2& barycentrics) {
+  return intersectTriangleBlockReference(block, laneMask, origin, direction, tMax, lane, barycentrics);
+}
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef TRIANGLEBLOCK_H
+#define TRIANGLEBLOCK_H
+
+#include <vector>
+
+#include "glm/glm.hpp"
+
+
+// Four triangles stored as one vertex and two edges in structure of arrays 
+// layout, precomputed so that the intersection kernels only have to do the 
+// per ray part of the Möller–Trumbore test. Unused lanes are zero and never hit.
+// As wide as the largest BVH leaf, so that a leaf usually fills one block.
+struct TriangleBlock {
+  static const unsigned int width = 4;
+
+  float v0x[width];
+  float v0y[width];
+  float v0z[width];
+  float e1x[width];
+  float e1y[width];
+  float e1z[width];
+  float e2x[width];
+  float e2y[width];
+  float e2z[width];
+
+  // Index of the triangle in each lane
+  unsigned int triangles[width];
+
+  void clear();
+
+  void set(const unsigned int lane, const unsigned int triangle, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2);
+};
+
+
+// Tests the ray against the lanes of the block set in laneMask. On a hit 
+// closer than tMax it returns true, shrinks tMax and reports the lane and 
+// the barycentric coordinates of the nearest hit. Dispatches to the SSE 
+// kernel when the CPU supports it.
+bool intersectTriangleBlock(const TriangleBlock& block, 
+                            const unsigned int laneMask,
+                            const glm::vec3& origin, 
+                            const glm::vec3& direction, 
+                            float& tMax, 
+                            unsigned int& lane, 
+                            glm::vec2& barycentrics);
+
+// Scalar reference implementation, performs the exact same floating point 
+// operations as the vector kernel and therefore gives identical hits.
+bool intersectTriangleBlockReference(const TriangleBlock& block, 
+                                     const unsigned int laneMask,
+                                     const glm::vec3& origin, 
+                                     const glm::vec3& direction, 
+                                     float& tMax, 
+                                     unsigned int& lane, 
+                                     glm::vec2& barycentrics);
+
+
+#endif // TRIANGLEBLOCK_H
@@ -0,0 +1,134 @@
+#include "WideBvh.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define WIDE_BVH_SIMD
+#include <immintrin.h>
+#endif
+
+
+#ifdef WIDE_BVH_SIMD
+
+unsigned int getSupportedBvhWidth() {
+  __builtin_cpu_init();
+  if( __builtin_cpu_supports("avx2") ) {
+    return 8;
+  }
+  if( __builtin_cpu_supports("sse2") ) {
+    return 4;
+  }
+  return 2;
+}
+
+
+unsigned int intersectChildren(const WideBvhNode<4>& node, 
+                               const glm::vec3& origin, 
+                               const glm::vec3& inversedDirection, 
+                               const float tMax, 
+                               float* distances) {
+  const __m128 ox = _mm_set1_ps(origin.x);
+  const __m128 oy = _mm_set1_ps(origin.y);
+  const __m128 oz = _mm_set1_ps(origin.z);
+  const __m128 ix = _mm_set1_ps(inversedDirection.x);
+  const __m128 iy = _mm_set1_ps(inversedDirection.y);
+  const __m128 iz = _mm_set1_ps(inversedDirection.z);
+
+  const __m128 tx1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.minX), ox), ix);
+  const __m128 tx2 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.maxX), ox), ix);
+  const __m128 ty1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.minY), oy), iy);
+  const __m128 ty2 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.maxY), oy), iy);
+  const __m128 tz1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.minZ), oz), iz);
+  const __m128 tz2 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.maxZ), oz), iz);
+
+  __m128 sMin = _mm_max_ps(_mm_min_ps(tx1, tx2), _mm_setzero_ps());
+  __m128 sMax = _mm_min_ps(_mm_max_ps(tx1, tx2), _mm_set1_ps(tMax));
+  sMin = _mm_max_ps(sMin, _mm_min_ps(ty1, ty2));
+  sMax = _mm_min_ps(sMax, _mm_max_ps(ty1, ty2));
+  sMin = _mm_max_ps(sMin, _mm_min_ps(tz1, tz2));
+  sMax = _mm_min_ps(sMax, _mm_max_ps(tz1, tz2));
+
+  _mm_storeu_ps(distances, sMin);
+
+  return static_cast<unsigned int>(_mm_movemask_ps(_mm_cmple_ps(sMin, sMax))) & node.occupied;
+}
+
+
+__attribute__((target("avx2")))
+unsigned int intersectChildren(const WideBvhNode<8>& node, 
+                               const glm::vec3& origin, 
+                               const glm::vec3& inversedDirection, 
+                               const float tMax, 
+                               float* distances) {
+  const __m256 ox = _mm256_set1_ps(origin.x);
+  const __m256 oy = _mm256_set1_ps(origin.y);
+  const __m256 oz = _mm256_set1_ps(origin.z);
+  const __m256 ix = _mm256_set1_ps(inversedDirection.x);
+  const __m256 iy = _mm256_set1_ps(inversedDirection.y);
+  const __m256 iz = _mm256_set1_ps(inversedDirection.z);
+
+  const __m256 tx1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(node.minX), ox), ix);
+  const __m256 tx2 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(node.maxX), ox), ix);
+  const __m256 ty1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(node.minY), oy), iy);
+  const __m256 ty2 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(node.maxY), oy), iy);
+  const __m256 tz1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(node.minZ), oz), iz);
+  const __m256 tz2 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(node.maxZ), oz), iz);
+
+  __m256 sMin = _mm256_max_ps(_mm256_min_ps(tx1, tx2), _mm256_setzero_ps());
+  __m256 sMax = _mm256_min_ps(_mm256_max_ps(tx1, tx2), _mm256_set1_ps(tMax));
+  sMin = _mm256_max_ps(sMin, _mm256_min_ps(ty1, ty2));
+  sMax = _mm256_min_ps(sMax, _mm256_max_ps(ty1, ty2));
+  sMin = _mm256_max_ps(sMin, _mm256_min_ps(tz1, tz2));
+  sMax = _mm256_min_ps(sMax, _mm256_max_ps(tz1, tz2));
+
+  _mm256_storeu_ps(distances, sMin);
+
+  return static_cast<unsigned int>(_mm256_movemask_ps(_mm256_cmp_ps(sMin, sMax, _CMP_LE_OQ))) & node.occupied;
+}
+
+#else
+
+unsigned int getSupportedBvhWidth() {
+  return 2;
+}
+
+
+template<unsigned int Width>
+static unsigned int intersectChildrenScalar(const WideBvhNode<Width>& node, 
+                                            const glm::vec3& origin, 
+                                            const glm::vec3& inversedDirection, 
+                                            const float tMax, 
+                                            float* distances) {
+  unsigned int mask = 0;
+  for(unsigned int i=0; i<Width; i++) {
+    if( !(node.occupied & (1u << i)) ) {
+      continue;
+    }
+    const BoundingBox bounds{glm::vec3{node.minX[i], node.minY[i], node.minZ[i]}, 
+                             glm::vec3{node.maxX[i], node.maxY[i], node.maxZ[i]}};
+    float tNear;
+    if( bounds.intersect(origin, inversedDirection, tMax, tNear) ) {
+      distances[i] = std::max(tNear, 0.0f);
+      mask |= 1u << i;
+    }
+  }
+  return mask;
+}
+
+
+unsigned int intersectChildren(const WideBvhNode<4>& node, 
+                               const glm::vec3& origin, 
+                               const glm::vec3& inversedDirection, 
+                               const float tMax, 
+                               float* distances) {
+  return intersectChildrenScalar(node, origin, inversedDirection, tMax, distances);
+}
+
+
+unsigned int intersectChildren(const WideBvhNode<8>& node, 
+                               const glm::vec3& origin, 
+                               const glm::vec3& inversedDirection, 
+                               const float tMax, 
+                               float* distances) {
+  return intersectChildrenScalar(node, origin, inversedDirection, tMax, distances);
+}
+
+#endif
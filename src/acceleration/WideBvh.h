@@ -0,0 +1,65 @@
+#ifndef WIDEBVH_H
+#define WIDEBVH_H
+
+#include <limits>
+
+#include "glm/glm.hpp"
+
+#include "acceleration/BoundingBox.h"
+
+
+// A node of a collapsed BVH with Width children. The child boxes are stored 
+// as structure of arrays so that all of them can be tested with one vector 
+// slab test. A child with count > 0 is a leaf referencing count primitives 
+// starting at child, otherwise child is the index of an interior node. 
+// Only the slots set in the occupied mask are in use.
+template<unsigned int Width>
+struct WideBvhNode {
+  float minX[Width];
+  float minY[Width];
+  float minZ[Width];
+  float maxX[Width];
+  float maxY[Width];
+  float maxZ[Width];
+  unsigned int child[Width];
+  unsigned int count[Width];
+  unsigned int occupied;
+
+  void clear() {
+    for(unsigned int i=0; i<Width; i++) {
+      setBounds(i, BoundingBox{glm::vec3{0.0f}, glm::vec3{0.0f}});
+      child[i] = 0;
+      count[i] = 0;
+    }
+    occupied = 0;
+  }
+
+  void setBounds(const unsigned int slot, const BoundingBox& bounds) {
+    const glm::vec3 min = bounds.getMin();
+    const glm::vec3 max = bounds.getMax();
+    minX[slot] = min.x; minY[slot] = min.y; minZ[slot] = min.z;
+    maxX[slot] = max.x; maxY[slot] = max.y; maxZ[slot] = max.z;
+  }
+};
+
+
+// Returns the widest node the running CPU can test in one go: 8 with AVX2, 
+// 4 with SSE and 2 when only the binary BVH can be used.
+unsigned int getSupportedBvhWidth();
+
+// Tests the ray against all child boxes of the node. Returns a bit mask of 
+// the children hit before tMax and writes their entry distances.
+unsigned int intersectChildren(const WideBvhNode<4>& node, 
+                               const glm::vec3& origin, 
+                               const glm::vec3& inversedDirection, 
+                               const float tMax, 
+                               float* distances);
+
+unsigned int intersectChildren(const WideBvhNode<8>& node, 
+                               const glm::vec3& origin, 
+                               const glm::vec3& inversedDirection, 
+                               const float tMax, 
+                               float* distances);
+
+
+#endif // WIDEBVH_H
@@ -0,0 +1,69 @@
+#include "Benchmarks.h"
+
+#include <iostream>
+#include <cmath>
+#include <stdexcept>
+
+#include "utils/Pcg32.h"
+#include "utils/random.h"
+
+
+int runBenchmark(const std::vector<std::string>& arguments) {
+  const std::string name = arguments.empty() ? "" : arguments[0];
+  const std::vector<std::string> benchmarkArguments{arguments.begin() + (arguments.empty() ? 0 : 1), arguments.end()};
+
+  if( name == "traversal" ) {
+    return benchmarkTraversal(benchmarkArguments);
+  } else if( name == "build" ) {
+    return benchmarkBuild(benchmarkArguments);
+  } else if( name == "random" ) {
+    return benchmarkRandom(benchmarkArguments);
+  }
+
+  std::cerr << "Unknown benchmark: " << name << std::endl;
+  std::cerr << "Benchmarks: traversal [maxTriangles], build [triangles...], random [maxThreads]" << std::endl;
+  return 1;
+}
+
+
+std::vector<glm::vec3> createTriangleSoup(const unsigned int triangles, const unsigned int seed) {
+  Pcg32 generator{seed};
+  const float size = 1.0f / std::cbrt(static_cast<float>(triangles));
+
+  std::vector<glm::vec3> verticies;
+  verticies.reserve(3 * triangles);
+
+  for(unsigned int i=0; i<triangles; i++) {
+    const glm::vec3 center = 2.0f * glm::vec3{generator.next0To1(), generator.next0To1(), generator.next0To1()} - 1.0f;
+    for(unsigned int v=0; v<3; v++) {
+      verticies.push_back(center + size * (glm::vec3{generator.next0To1(), generator.next0To1(), generator.next0To1()} - 0.5f));
+    }
+  }
+
+  return verticies;
+}
+
+
+void createBenchmarkRays(const unsigned int count, const unsigned int seed, std::vector<glm::vec3>& origins, std::vector<glm::vec3>& directions) {
+  Pcg32 generator{seed, 1};
+  origins.resize(count);
+  directions.resize(count);
+
+  for(unsigned int i=0; i<count; i++) {
+    origins[i] = 3.0f * getRandomSphereVector(glm::vec2{generator.next0To1(), generator.next0To1()});
+    const glm::vec3 target = 2.0f * glm::vec3{generator.next0To1(), generator.next0To1(), generator.next0To1()} - 1.0f;
+    directions[i] = glm::normalize(target - origins[i]);
+  }
+}
+
+
+unsigned long long getBenchmarkArgument(const std::vector<std::string>& arguments, const unsigned int index, const unsigned long long fallback) {
+  if( index >= arguments.size() ) {
+    return fallback;
+  }
+  try {
+    return std::stoull(arguments[index]);
+  } catch( const std::logic_error& ) {
+    throw std::invalid_argument{"Benchmark argument is not a number: " + arguments[index]};
+  }
+}
@@ -0,0 +1,45 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include <vector>
+#include <string>
+#include <chrono>
+
+#include "glm/glm.hpp"
+
+
+// Microbenchmarks run with ./main --benchmark <name> [arguments]. Each prints a table of its 
+// results to std::cout and returns the exit status of the program.
+int runBenchmark(const std::vector<std::string>& arguments);
+
+// Rays per second of the mesh BVH against intersecting every triangle, from 1k triangles 
+// up to the largest power of four not above the first argument, 1M by default
+int benchmarkTraversal(const std::vector<std::string>& arguments);
+
+// Build time of the BVH over triangle soups of the sizes given as arguments, 1M and 10M 
+// by default, serially and on a thread pool with a worker per additional hardware thread
+int benchmarkBuild(const std::vector<std::string>& arguments);
+
+// Random values per second of each thread, drawn from a generator per thread and from the 
+// sequences of every sampler, one at a time and in batches where there are SIMD kernels. 
+// On 1, 2, 4 ... threads up to the first argument, the number of hardware threads by 
+// default. Flat rates per thread mean nothing is shared.
+int benchmarkRandom(const std::vector<std::string>& arguments);
+
+
+// Number of triangles uniformly scattered in [-1, 1]^3, sized so that the 
+// soup stays about equally dense whatever the count
+std::vector<glm::vec3> createTriangleSoup(const unsigned int triangles, const unsigned int seed);
+
+// Rays from outside the unit cube towards random points in it
+void createBenchmarkRays(const unsigned int count, const unsigned int seed, std::vector<glm::vec3>& origins, std::vector<glm::vec3>& directions);
+
+inline double secondsSince(const std::chrono::high_resolution_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// Value of the argument at index, fallback when it is not given
+unsigned long long getBenchmarkArgument(const std::vector<std::string>& arguments, const unsigned int index, const unsigned long long fallback);
+
+
+#endif // BENCHMARKS_H
@@ -0,0 +1,83 @@
+#include "Benchmarks.h"
+
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <algorithm>
+
+#include "acceleration/Bvh.h"
+#include "acceleration/BoundingBox.h"
+
+#include "thread/ThreadPool.h"
+
+
+int benchmarkBuild(const std::vector<std::string>& arguments) {
+  std::vector<unsigned long long> sizes;
+  for(unsigned int i=0; i<arguments.size(); i++) {
+    sizes.push_back(getBenchmarkArgument(arguments, i, 0));
+  }
+  if( sizes.empty() ) {
+    sizes = {1000000, 10000000};
+  }
+
+  // The thread that builds helps the workers while it waits, as in a render
+  const unsigned int numberOfWorkers = std::max(1u, std::thread::hardware_concurrency()) - 1;
+
+  std::cout << std::setw(10) << "triangles"
+            << std::setw(10) << "workers"
+            << std::setw(12) << "build ms"
+            << std::setw(14) << "Mtriangles/s"
+            << std::setw(10) << "sah cost"
+            << std::setw(8) << "same" << std::endl;
+
+  int status = 0;
+
+  for(const unsigned long long triangles : sizes) {
+    std::vector<BoundingBox> bounds;
+    {
+      const std::vector<glm::vec3> verticies = createTriangleSoup(triangles, 1);
+      bounds.reserve(triangles);
+      for(unsigned int i=0; i<triangles; i++) {
+        BoundingBox triangleBounds{verticies[3*i], verticies[3*i]};
+        triangleBounds.expand(verticies[3*i+1]);
+        triangleBounds.expand(verticies[3*i+2]);
+        bounds.push_back(triangleBounds);
+      }
+    }
+
+    Bvh serial;
+    auto start = std::chrono::high_resolution_clock::now();
+    serial.build(bounds);
+    const double serialSeconds = secondsSince(start);
+
+    std::cout << std::setw(10) << triangles
+              << std::setw(10) << "serial"
+              << std::setw(12) << std::fixed << std::setprecision(0) << serialSeconds * 1000.0
+              << std::setw(14) << std::setprecision(2) << triangles / serialSeconds / 1e6
+              << std::setw(10) << serial.getSahCost()
+              << std::setw(8) << "-" << std::endl;
+
+    ThreadPool threadPool{numberOfWorkers};
+    Bvh parallel;
+    start = std::chrono::high_resolution_clock::now();
+    parallel.build(bounds, &threadPool);
+    const double parallelSeconds = secondsSince(start);
+
+    // The pool shall give the very same tree
+    const bool same = parallel.getPrimitiveIndices() == serial.getPrimitiveIndices() && 
+                      parallel.getNodes().size() == serial.getNodes().size() && 
+                      parallel.getSahCost() == serial.getSahCost();
+    if( !same ) {
+      status = 1;
+    }
+
+    std::cout << std::setw(10) << triangles
+              << std::setw(10) << numberOfWorkers
+              << std::setw(12) << std::setprecision(0) << parallelSeconds * 1000.0
+              << std::setw(14) << std::setprecision(2) << triangles / parallelSeconds / 1e6
+              << std::setw(10) << parallel.getSahCost()
+              << std::setw(8) << (same ? "yes" : "no") << std::endl;
+  }
+
+  return status;
+}
@@ -0,0 +1,136 @@
+#include "Benchmarks.h"
+
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <memory>
+#include <algorithm>
+
+#include "samplers/Sampler.h"
+#include "samplers/SamplerIndependent.h"
+#include "samplers/SamplerStratified.h"
+#include "samplers/SamplerHalton.h"
+#include "samplers/SamplerSobol.h"
+
+#include "utils/Pcg32.h"
+#include "utils/RandomSequence.h"
+
+
+// Values every thread draws
+static const unsigned int valuesPerThread = 1u << 22;
+
+// Dimensions of each sample, about those of a path of a few bounces
+static const unsigned int dimensionsPerSample = 16;
+
+
+// Draws values from a generator of its own, sums them so that none is left out
+static float drawGenerator(const unsigned int thread) {
+  Pcg32 generator{0x853c49e6748fea9bULL, thread};
+  float sum = 0.0f;
+  for(unsigned int i=0; i<valuesPerThread; i++) {
+    sum += generator.next0To1();
+  }
+  return sum;
+}
+
+
+// The same values drawn with fill()
+static float fillGenerator(const unsigned int thread) {
+  Pcg32 generator{0x853c49e6748fea9bULL, thread};
+  float values[dimensionsPerSample];
+  float sum = 0.0f;
+  for(unsigned int i=0; i<valuesPerThread; i+=dimensionsPerSample) {
+    generator.fill(values, dimensionsPerSample);
+    for(const float value : values) {
+      sum += value;
+    }
+  }
+  return sum;
+}
+
+
+// Draws values as paths do, a sequence per sample of a pixel of its own, 
+// one dimension at a time or all dimensions of a sample in one batch
+static float drawSequences(const Sampler& sampler, const unsigned int thread, const bool batch) {
+  float values[dimensionsPerSample];
+  float sum = 0.0f;
+  for(unsigned int sample=0; sample<valuesPerThread / dimensionsPerSample; sample++) {
+    RandomSequence sequence{&sampler, thread, sample};
+    if( batch ) {
+      sequence.next0To1(values, dimensionsPerSample);
+      for(const float value : values) {
+        sum += value;
+      }
+    } else {
+      for(unsigned int dimension=0; dimension<dimensionsPerSample; dimension++) {
+        sum += sequence.next0To1();
+      }
+    }
+  }
+  return sum;
+}
+
+
+// A row of the table, without a sampler it draws from a Pcg32
+struct Generator {
+  std::string name;
+  std::unique_ptr<Sampler> sampler;
+  bool batch;
+};
+
+
+int benchmarkRandom(const std::vector<std::string>& arguments) {
+  const unsigned int maxThreads = static_cast<unsigned int>(getBenchmarkArgument(arguments, 0, std::max(1u, std::thread::hardware_concurrency())));
+
+  const unsigned int samplesPerPixel = valuesPerThread / dimensionsPerSample;
+  std::vector<Generator> generators;
+  generators.push_back(Generator{"pcg32", nullptr, false});
+  generators.push_back(Generator{"pcg32 fill", nullptr, true});
+  generators.push_back(Generator{"independent", std::unique_ptr<Sampler>{new SamplerIndependent{1, samplesPerPixel}}, false});
+  generators.push_back(Generator{"indep. fill", std::unique_ptr<Sampler>{new SamplerIndependent{1, samplesPerPixel}}, true});
+  generators.push_back(Generator{"stratified", std::unique_ptr<Sampler>{new SamplerStratified{1, samplesPerPixel}}, false});
+  generators.push_back(Generator{"halton", std::unique_ptr<Sampler>{new SamplerHalton{1, samplesPerPixel}}, false});
+  generators.push_back(Generator{"sobol", std::unique_ptr<Sampler>{new SamplerSobol{1, samplesPerPixel}}, false});
+
+  std::cout << std::setw(12) << "generator"
+            << std::setw(10) << "threads"
+            << std::setw(18) << "Msamples/s/thread"
+            << std::setw(16) << "Msamples/s" << std::endl;
+
+  for(const Generator& generator : generators) {
+    for(unsigned int threads=1; threads<=maxThreads; threads*=2) {
+      std::vector<float> sums(threads);
+      std::vector<std::thread> workers;
+
+      const auto start = std::chrono::high_resolution_clock::now();
+      for(unsigned int thread=0; thread<threads; thread++) {
+        workers.emplace_back([&generator, &sums, thread]() {
+          if( generator.sampler ) {
+            sums[thread] = drawSequences(*generator.sampler, thread, generator.batch);
+          } else {
+            sums[thread] = generator.batch ? fillGenerator(thread) : drawGenerator(thread);
+          }
+        });
+      }
+      for(std::thread& worker : workers) {
+        worker.join();
+      }
+      const double seconds = secondsSince(start);
+
+      float sum = 0.0f;
+      for(const float threadSum : sums) {
+        sum += threadSum;
+      }
+
+      // Uniform values average a half, anything else means a broken generator
+      const double mean = sum / (static_cast<double>(threads) * valuesPerThread);
+      std::cout << std::setw(12) << generator.name
+                << std::setw(10) << threads
+                << std::setw(18) << std::fixed << std::setprecision(1) << valuesPerThread / seconds / 1e6
+                << std::setw(16) << threads * static_cast<double>(valuesPerThread) / seconds / 1e6
+                << (std::abs(mean - 0.5) > 0.01 ? "  mean off" : "") << std::endl;
+    }
+  }
+
+  return 0;
+}
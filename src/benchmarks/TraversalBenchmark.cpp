@@ -0,0 +1,142 @@
+#include "Benchmarks.h"
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+
+#include "Ray.h"
+
+#include "objects/meshes/TriangleMesh.h"
+
+#include "acceleration/Bvh.h"
+#include "acceleration/BvhStatistics.h"
+#include "acceleration/TriangleBlock.h"
+
+
+// Nearest hit of the ray over all blocks, without any hierarchy
+static float intersectBruteForce(const std::vector<TriangleBlock>& blocks, const glm::vec3& origin, const glm::vec3& direction) {
+  float tMax = std::numeric_limits<float>::max();
+  unsigned int lane;
+  glm::vec2 barycentrics;
+
+  for(unsigned int block=0; block<blocks.size(); block++) {
+    intersectTriangleBlock(blocks[block], (1u << TriangleBlock::width) - 1, origin, direction, tMax, lane, barycentrics);
+  }
+
+  return tMax;
+}
+
+
+static void printRow(const unsigned long long triangles, 
+                     const std::string& bvh, 
+                     const std::string& build, 
+                     const double rate, 
+                     const std::string& steps, 
+                     const double speedup, 
+                     const std::string& mismatches) {
+  std::cout << std::setw(10) << triangles
+            << std::setw(8) << bvh
+            << std::setw(12) << build
+            << std::setw(14) << std::fixed << std::setprecision(0) << rate
+            << std::setw(12) << steps
+            << std::setw(10) << speedup
+            << std::setw(12) << mismatches << std::endl;
+}
+
+
+static std::string format(const double value) {
+  std::ostringstream stream;
+  stream << std::fixed << std::setprecision(1) << value;
+  return stream.str();
+}
+
+
+int benchmarkTraversal(const std::vector<std::string>& arguments) {
+  const unsigned long long maxTriangles = getBenchmarkArgument(arguments, 0, 1 << 20);
+  const unsigned int numberOfRays = 1 << 16;
+  const unsigned int widths[] = {2, 4, 8};
+
+  // Brute force tests every triangle, so it gets fewer rays on the larger meshes
+  const unsigned long long bruteForceTests = 1ull << 28;
+
+  std::vector<glm::vec3> origins;
+  std::vector<glm::vec3> directions;
+  createBenchmarkRays(numberOfRays, 2, origins, directions);
+
+  // Traversal steps per ray are only counted when compiled with -DBVH_STATISTICS
+  std::cout << std::setw(10) << "triangles"
+            << std::setw(8) << "bvh"
+            << std::setw(12) << "build ms"
+            << std::setw(14) << "rays/s"
+            << std::setw(12) << "steps/ray"
+            << std::setw(10) << "speedup"
+            << std::setw(12) << "mismatches" << std::endl;
+
+  const unsigned int preferredWidth = Bvh::getPreferredWidth();
+  int status = 0;
+
+  for(unsigned long long triangles=1 << 10; triangles<=maxTriangles; triangles*=4) {
+    const std::vector<glm::vec3> verticies = createTriangleSoup(triangles, 1);
+
+    std::vector<TriangleBlock> blocks((triangles + TriangleBlock::width - 1) / TriangleBlock::width);
+    for(unsigned int block=0; block<blocks.size(); block++) {
+      blocks[block].clear();
+    }
+    for(unsigned int i=0; i<triangles; i++) {
+      blocks[i / TriangleBlock::width].set(i % TriangleBlock::width, i, verticies[3*i], verticies[3*i+1], verticies[3*i+2]);
+    }
+
+    const unsigned int bruteForceRays = static_cast<unsigned int>(std::max(64ull, std::min<unsigned long long>(numberOfRays, bruteForceTests / triangles)));
+    std::vector<float> bruteForceT(bruteForceRays);
+    auto start = std::chrono::high_resolution_clock::now();
+    for(unsigned int i=0; i<bruteForceRays; i++) {
+      bruteForceT[i] = intersectBruteForce(blocks, origins[i], directions[i]);
+    }
+    const double bruteForceRate = bruteForceRays / secondsSince(start);
+    printRow(triangles, "brute", "-", bruteForceRate, "-", 1.0, "-");
+
+    for(const unsigned int width : widths) {
+      Bvh::setPreferredWidth(width);
+
+      start = std::chrono::high_resolution_clock::now();
+      const TriangleMesh mesh{verticies};
+      const double buildSeconds = secondsSince(start);
+
+      std::vector<float> nearestT(numberOfRays);
+      const unsigned long long stepsBefore = BvhStatistics::getTraversalSteps(width);
+      start = std::chrono::high_resolution_clock::now();
+      for(unsigned int i=0; i<numberOfRays; i++) {
+        const Ray ray{origins[i], directions[i]};
+        const std::pair<Mesh::Intersection, HitRecord> hit = mesh.getIntersections(&ray);
+        nearestT[i] = hit.first == Mesh::Intersection::MISS ? std::numeric_limits<float>::max() : hit.second.t;
+      }
+      const double rate = numberOfRays / secondsSince(start);
+      const unsigned long long steps = BvhStatistics::getTraversalSteps(width) - stepsBefore;
+
+      unsigned int mismatches = 0;
+      for(unsigned int i=0; i<bruteForceRays; i++) {
+        if( nearestT[i] != bruteForceT[i] ) {
+          mismatches++;
+        }
+      }
+      if( mismatches > 0 ) {
+        status = 1;
+      }
+
+      printRow(triangles, 
+               std::to_string(width), 
+               format(buildSeconds * 1000.0), 
+               rate, 
+               BvhStatistics::isEnabled() ? format(steps / (double) numberOfRays) : "-", 
+               rate / bruteForceRate, 
+               std::to_string(mismatches));
+    }
+  }
+
+  Bvh::setPreferredWidth(preferredWidth);
+
+  return status;
+}
@@ -13,6 +13,8 @@
 #include <limits>
 #include <sstream>
 #include <fstream>
+#include <atomic>
+#include <memory>
 
 #define GLM_FORCE_RADIANS
 #include "glm/glm.hpp"
@@ -20,7 +22,14 @@
 
 #include "Camera.h"
 #include "Scene.h"
+#include "PathIntegrator.h"
+#include "WavefrontIntegrator.h"
+#include "ProgressiveRenderer.h"
+#include "Denoiser.h"
+#include "AovBuffer.h"
+#include "PixelEstimate.h"
 #include "Ray.h"
+#include "RayPacket.h"
 #include "objects/meshes/SphereMesh.h"
 #include "objects/meshes/BoxMesh.h"
 #include "objects/meshes/BoundingBoxMesh.h"
@@ -32,10 +41,18 @@
 #include "objects/brdfs/BrdfLambertian.h"
 #include "objects/brdfs/BrdfOrenNayar.h"
 
+#include "samplers/SamplerIndependent.h"
+#include "samplers/SamplerStratified.h"
+#include "samplers/SamplerHalton.h"
+#include "samplers/SamplerSobol.h"
+
+#include "acceleration/Bvh.h"
+#include "acceleration/BvhCache.h"
+#include "acceleration/BvhStatistics.h"
+
 #include "thread/ThreadPool.h"
 #include "thread/WorkItem.h"
 
-#include "utils/Node.h"
 #include "utils/random.h"
 #include "utils/math.h"
 #include "utils/image.h"
@@ -45,8 +62,25 @@
 #include "parser/OBJParser.h"
 #include "parser/Config.h"
 
+#include "benchmarks/Benchmarks.h"
+#include "tests/Tests.h"
+
+
+std::unique_ptr<Sampler> createSampler(const std::string& name, const unsigned int seed, const unsigned int samplesPerPixel) {
+  if( name == "independent" ) {
+    return std::unique_ptr<Sampler>{new SamplerIndependent{seed, samplesPerPixel}};
+  } else if( name == "stratified" ) {
+    return std::unique_ptr<Sampler>{new SamplerStratified{seed, samplesPerPixel}};
+  } else if( name == "halton" ) {
+    return std::unique_ptr<Sampler>{new SamplerHalton{seed, samplesPerPixel}};
+  } else if( name == "sobol" ) {
+    return std::unique_ptr<Sampler>{new SamplerSobol{seed, samplesPerPixel}};
+  }
+  throw std::invalid_argument{"Unknown sampler: " + name};
+}
 
-Scene createScene() {
+
+Scene createScene(ThreadPool& threadPool) {
   Scene scene;
 
   OpaqueObject* boundingBox = new OpaqueObject{"boundingBox", new BoundingBoxMesh{glm::vec2{-10, 10}, glm::vec2{-10, 10}, glm::vec2{-10, 10}},
@@ -114,11 +148,27 @@ Scene createScene() {
     objVertices.push_back(glm::vec3{vert.x, vert.y, vert.z}*scale + translation);
     objNormals.push_back(glm::normalize(glm::vec3{normal.x, normal.y, normal.z}));
   }
-  TransparentObject* diamond = new TransparentObject{"diamond", new TriangleMesh{objVertices, objNormals}, 
+  TransparentObject* diamond = new TransparentObject{"diamond", new TriangleMesh{objVertices, objNormals, &threadPool}, 
                                            1.2f, 0.5f, glm::vec3{(float)255/(float)255, (float)51/(float)255, (float)204/(float)255}};
   scene.add(diamond);
 
 
+  // Many small lights spread through the room, together as bright as lightPlane3
+  const unsigned int numberOfBenchmarkLights = Config::getInstance().getValue<unsigned int>("benchmarkLights");
+  const float benchmarkLightRadius = 0.02f;
+  for(unsigned int i=0; i<numberOfBenchmarkLights; i++) {
+    // Golden ratio sequences fill the room evenly
+    const glm::vec3 position = glm::vec3{std::fmod(0.5f + i * 0.6180340f, 1.0f),
+                                         std::fmod(0.5f + i * 0.7548777f, 1.0f),
+                                         std::fmod(0.5f + i * 0.5698403f, 1.0f)} * 19.0f - 9.5f;
+    const float intensity = 64.0f / (numberOfBenchmarkLights * 4.0f * M_PI * benchmarkLightRadius * benchmarkLightRadius);
+    scene.add(new OpaqueObject{"benchmarkLight" + std::to_string(i), new SphereMesh{position, benchmarkLightRadius},
+                               new BrdfLambertian{1.0f},
+                               true,
+                               intensity * glm::vec3{1.0f, 1.0f, 1.0f}});
+  }
+
+  scene.setLightBvh(Config::getInstance().getValue<bool>("lightBvh"));
   scene.complete();
 
   return scene;
@@ -127,6 +177,13 @@ Scene createScene() {
 
 int main(const int argc, const char* argv[]) {
 
+  if( argc >= 2 && std::string{argv[1]} == "--test" ) {
+    return runTests();
+  }
+  if( argc >= 2 && std::string{argv[1]} == "--benchmark" ) {
+    return runBenchmark(std::vector<std::string>{argv + 2, argv + argc});
+  }
+
   const auto startTime = std::chrono::high_resolution_clock::now();
 
   Config& config = Config::getInstance();
@@ -135,12 +192,47 @@ int main(const int argc, const char* argv[]) {
   const unsigned int height = config.getValue<unsigned int>("height");
   const unsigned int numberOfSamples = config.getValue<unsigned int>("numberOfSamples");
   const unsigned int numberOfShadowRays = config.getValue<unsigned int>("numberOfShadowRays");
-  const float probabilityNotToTerminateRay = config.getValue<float>("probabilityNotToTerminateRay");
+  const unsigned int seed = config.getValue<unsigned int>("seed");
+  const std::string samplerName = config.getValue<std::string>("sampler");
+  const unsigned int rouletteMinimumDepth = config.getValue<unsigned int>("rouletteMinimumDepth");
+  const unsigned int maximumDepth = config.getValue<unsigned int>("maximumDepth");
+  const bool packetTracing = config.getValue<bool>("packetTracing");
+  const bool wavefront = config.getValue<bool>("wavefront");
+  const bool progressive = config.getValue<bool>("progressive");
+  const float progressiveTimeBudget = config.getValue<float>("progressiveTimeBudget");
+  const float progressiveOutputInterval = config.getValue<float>("progressiveOutputInterval");
+  const float adaptiveThreshold = config.getValue<float>("adaptiveThreshold");
+  const unsigned int adaptiveRoundSamples = std::max(2u, config.getValue<unsigned int>("adaptiveRoundSamples"));
+  const bool denoise = config.getValue<bool>("denoise");
+  const unsigned int denoiseIterations = config.getValue<unsigned int>("denoiseIterations");
+  const float denoiseColorSigma = config.getValue<float>("denoiseColorSigma");
+  const bool compareToReference = config.getValue<bool>("compareToReference");
+  const bool writeAovs = config.getValue<bool>("aovs");
+  Bvh::setPreferredWidth(config.getValue<unsigned int>("bvhWidth"));
+  Bvh::setRebuildThreshold(config.getValue<float>("bvhRebuildThreshold"));
+  if( config.getValue<bool>("bvhCache") ) {
+    BvhCache::setDirectory(config.getValue<std::string>("bvhCacheDirectory"));
+  }
   std::cout << "width: " << width << std::endl;
   std::cout << "height: " << height << std::endl;
   std::cout << "numberOfSamples: " << numberOfSamples << std::endl;
   std::cout << "numberOfShadowRays: " << numberOfShadowRays << std::endl;
-  std::cout << "probabilityNotToTerminateRay: " << probabilityNotToTerminateRay << std::endl;
+  std::cout << "seed: " << seed << std::endl;
+  std::cout << "sampler: " << samplerName << std::endl;
+  std::cout << "rouletteMinimumDepth: " << rouletteMinimumDepth << std::endl;
+  std::cout << "maximumDepth: " << maximumDepth << std::endl;
+  std::cout << "packetTracing: " << packetTracing << std::endl;
+  std::cout << "wavefront: " << wavefront << std::endl;
+  std::cout << "progressive: " << progressive << std::endl;
+  std::cout << "adaptiveThreshold: " << adaptiveThreshold << std::endl;
+  if( adaptiveThreshold > 0.0f && (wavefront || progressive) ) {
+    std::cout << "warning: adaptiveThreshold is ignored by the " 
+              << (progressive ? "progressive" : "wavefront") << " mode" << std::endl;
+  }
+  std::cout << "denoise: " << denoise << std::endl;
+  std::cout << "aovs: " << writeAovs << std::endl;
+  std::cout << "bvhWidth: " << Bvh::getPreferredWidth() << std::endl;
+  std::cout << "bvhCache: " << BvhCache::getDirectory() << std::endl;
   const glm::mat4 rotation2 = glm::rotate(-0.1f, glm::vec3{1.0f, 0.0f, 0.0f});
   glm::mat3 rotation = computeRotationMatrix(glm::normalize(glm::vec3{0.0f, 0.1f, 1.0f}));
 
@@ -157,260 +249,313 @@ int main(const int argc, const char* argv[]) {
                 3.0f,                        // viewPlaneDistance
                 numberOfSamples};            // superSampling
 
-  const std::vector<Ray*> rays = camera.getRays();
+  ThreadPool threadPool;
+  // threadPool.setNumberOfWorkers(0); 
 
-  Scene scene = createScene();
+  Scene scene = createScene(threadPool);
 
   std::vector<unsigned char> image;
   image.resize(width * height * 4);
   std::fill(image.begin(), image.end(), 0);
 
-  ThreadPool threadPool;
-  // threadPool.setNumberOfWorkers(0); 
-
   std::mutex update;
-  unsigned int columnCounter = 0;
+  unsigned int tileCounter = 0;
   glm::vec3 globalMaxIntensity{0.0f, 0.0f, 0.0f};
   glm::vec3 globalMinIntensity{0.0f, 0.0f, 0.0f};
 
-  const float rootImportance = 1.0f;
-
-  for(unsigned x = 0; x < width; x++) {
-    WorkItem* workItem = new WorkItem([&probabilityNotToTerminateRay, &update, &globalMaxIntensity, &globalMinIntensity, &columnCounter, 
-                                       &image, &scene, &rays, &rootImportance, &numberOfSamples, &numberOfShadowRays, &height, &width, x]() {
-
-      glm::vec3 localMaxIntensity{0.0f, 0.0f, 0.0f};
-      glm::vec3 localMinIntensity{0.0f, 0.0f, 0.0f};
-
-      for(unsigned y = 0; y < height; y++) {
-
-        Node* roots[numberOfSamples];
-
-        for(unsigned int s=0; s<numberOfSamples; s++) {
-
-          Node* root = new Node{rays[numberOfSamples * width * y + numberOfSamples * x + s], rootImportance};
-          roots[s] = root;
-          
-          const std::function<void(Node*)> traverse = [&probabilityNotToTerminateRay, &numberOfShadowRays, &scene, &traverse, &root](Node* node) {
-            const Ray* ray = node->getRay();
-            const std::pair<Object*, glm::vec3> intersection = scene.intersect(ray);
-
-            if( intersection.first == nullptr ) { // No intersection found
-              // const glm::vec3 direction = ray->getDirection();
-              // const float importance = node->getImportance();
-              // const glm::vec3 origin = ray->getOrigin();
-              // std::cout << std::endl;
-              // std::cout << "------------------------" << std::endl;
-              // std::cout << "Root: " << (node == root) << std::endl;
-              // std::cout << "Importance: "  << importance << std::endl;
-              // std::cout << "Origin: "  << origin.x << " " << origin.y << " " << origin.z << std::endl;
-              // std::cout << "Direction: "  << direction.x << " " << direction.y << " " << direction.z << std::endl;
-              // std::cout << "Intersection: "  << intersection.second.x << " " << intersection.second.y << " " << intersection.second.z << std::endl;
-              // throw std::invalid_argument{"No intersection found."};
-            } else if( intersection.first->isLight() ) { // If intersecting object is a light source
-
-              node->setIntensity(intersection.first->getIntensity());
-
-            } else if( intersection.first->isTransparent() ) { // If intersecting object is transparent
-
-              const glm::vec3 origin = ray->getOrigin();
-              const glm::vec3 direction = ray->getDirection();
-              glm::vec3 normal = intersection.first->getNormal(intersection.second);
-              const glm::vec3 viewDirection = glm::normalize(origin); // TODO?: camera not always in origin
-
-              const glm::vec3 reflection = glm::reflect(direction, normal);
-
-              const float nodeRefractionIndex = node->getRefractionIndex();
-              const float materialRefractionIndex = dynamic_cast<TransparentObject*>(intersection.first)->getRefractionIndex();
-
-              float n1 = nodeRefractionIndex;
-              float n2 = materialRefractionIndex;
-
-              if( nodeRefractionIndex == materialRefractionIndex 
-                  && 
-                  node->getLastIntersectedObject() == intersection.first ) {
-
-                // n1 = materialRefractionIndex;
-                n2 = 1.0f; // Air
-                // std::cout << "HEJ!" << std::endl;
-                normal = -normal;
-              } 
-
-              const float refractionIndexRatio = n1 / n2; 
-              const glm::vec3 refraction = glm::refract(direction, normal, refractionIndexRatio);
-
-              // std::cout << "refraction: " << refraction.x << " " << refraction.y << " " << refraction.z << std::endl;
-              // std::cout << "refractionIndexRatio: " << refractionIndexRatio << std::endl;
-
-              const float importance = node->getImportance();
-              const float transparency = dynamic_cast<TransparentObject*>(intersection.first)->getTransparancy();
-
-              const glm::vec3 newReflectedOrigin = intersection.second + (normal - direction) * getEpsilon();
-              const glm::vec3 newRefractedOrigin = intersection.second + (direction - normal) * getEpsilon();
-
-              // TODO: Compute Fresnel in order to give the right porportions to the reflected and refracted part!
-
-              if( importance > 0.001f ) {
-              const float reflectedImportance = importance * (1.0f - transparency);
-              node->setReflected(new Node{new Ray{newReflectedOrigin, reflection}, 
-                                          reflectedImportance, intersection.first, n2});
-
-              const float refractedImportance = importance * transparency;
-              node->setRefracted(new Node{new Ray{newRefractedOrigin, refraction}, 
-                                          refractedImportance, intersection.first, n2, true});
-
-              traverse(node->getReflected());
+  const std::unique_ptr<Sampler> sampler = createSampler(samplerName, seed, numberOfSamples);
 
-              // const float brewster = std::atan2(n2 , n1);
-              // const float brewster = std::asin(n1 / n2);
-              // const float angle = std::acos(glm::dot(-direction, normal));
-              // if( angle <= brewster ) {
-                // std::cout << "GO!!" << std::endl;
-                traverse(node->getRefracted());
-              // } 
-              // std::cout << "CODE!" << std::endl;
+  const PathIntegrator integrator{scene, numberOfShadowRays, rouletteMinimumDepth, maximumDepth};
+  WavefrontIntegrator wavefrontIntegrator{scene, integrator, camera, threadPool, packetTracing, *sampler};
+  ProgressiveRenderer progressiveRenderer{scene, integrator, camera, threadPool, packetTracing, *sampler};
+  Denoiser denoiser{scene, camera, threadPool, *sampler, denoiseIterations, denoiseColorSigma};
 
-              const glm::vec3 color = intersection.first->getIntensity();
-              const glm::vec3 intensity = (node->getReflected()->getIntensity() * reflectedImportance 
-                                         + node->getRefracted()->getIntensity() * refractedImportance) / importance ;
+  std::string name = config.getValue<std::string>("name");
+  if( argc == 2 ) {
+    name = argv[1];
+  }
+  const std::string file = name + ".png";
 
-              node->setIntensity(intensity * color);
+  std::unique_ptr<AovBuffer> aovs;
+  if( writeAovs ) {
+    aovs.reset(new AovBuffer{width, height});
+  }
 
-              delete node->getReflected();
-              delete node->getRefracted();
+  // The image is rendered in tiles of tileSize x tileSize pixels, the camera rays 
+  // of each sample in a tile are traced together as one packet
+  const unsigned int tileSize = 8;
+  const unsigned int numberOfTiles = ((width + tileSize - 1) / tileSize) * ((height + tileSize - 1) / tileSize);
+  std::atomic<unsigned long long> primaryRayMicroseconds{0};
+  std::atomic<unsigned long long> tracedSamples{0};
+
+  // Mean radiance of each pixel, row by row from the top left
+  std::vector<glm::vec3> colors(width * height);
+
+  // Number of samples of each pixel, in the order of colors. Only adaptive sampling 
+  // leaves pixels with fewer samples than the others.
+  std::vector<unsigned int> samples(width * height, numberOfSamples);
+
+  const auto renderStartTime = std::chrono::high_resolution_clock::now();
+
+  if( progressive ) {
+    // The intermediate images go to the same file as the final one
+    colors = progressiveRenderer.render(numberOfSamples, 
+                                        progressiveTimeBudget, 
+                                        progressiveOutputInterval, 
+                                        [&file, &width, &height](const std::vector<glm::vec3>& colors) {
+      std::vector<unsigned char> intermediateImage(width * height * 4);
+      for(unsigned int y=0; y<height; y++) {
+        for(unsigned int x=0; x<width; x++) {
+          writePixel(intermediateImage, width, x, y, colors[y * width + x]);
+        }
+      }
+      outputImage(file, intermediateImage, width, height);
+    }, aovs.get());
+    std::fill(samples.begin(), samples.end(), progressiveRenderer.getPasses());
+
+  } else if( wavefront ) {
+    colors = wavefrontIntegrator.render(numberOfSamples, aovs.get());
+  } else {
+    for(unsigned tileY = 0; tileY < height; tileY += tileSize) {
+      for(unsigned tileX = 0; tileX < width; tileX += tileSize) {
+        WorkItem* workItem = new WorkItem([&update, &globalMaxIntensity, &globalMinIntensity, &tileCounter, &numberOfTiles,
+                                           &primaryRayMicroseconds, &tracedSamples, &packetTracing, &tileSize,
+                                           &adaptiveThreshold, &adaptiveRoundSamples, &sampler, &aovs,
+                                           &colors, &samples, &scene, &integrator, &camera, &numberOfSamples, &height, &width, tileX, tileY]() {
+
+          glm::vec3 localMaxIntensity{0.0f, 0.0f, 0.0f};
+          glm::vec3 localMinIntensity{0.0f, 0.0f, 0.0f};
+
+          const unsigned int tileWidth = std::min(tileSize, width - tileX);
+          const unsigned int tileHeight = std::min(tileSize, height - tileY);
+          const unsigned int numberOfPixels = tileWidth * tileHeight;
+
+          PixelEstimate estimates[RayPacket::maxSize];
+
+          // The pixels that still take samples, in the order of their camera rays in the packet
+          unsigned int activePixels[RayPacket::maxSize];
+          unsigned int numberOfActivePixels = numberOfPixels;
+          for(unsigned int i=0; i<numberOfPixels; i++) {
+            activePixels[i] = i;
+          }
+
+          Camera::RowBasis rowBases[tileSize];
+          for(unsigned int y=0; y<tileHeight; y++) {
+            rowBases[y] = camera.getRowBasis(tileY + y);
+          }
+
+          // The camera rays of the current sample, generated here instead of up front
+          std::vector<Ray> cameraRays;
+          cameraRays.reserve(RayPacket::maxSize);
+
+          RayPacket packet;
+          std::pair<Object*, HitRecord> intersections[RayPacket::maxSize];
+
+          // The random numbers of each camera ray and its path, keyed by pixel and sample
+          RandomSequence sequences[RayPacket::maxSize];
+
+          for(unsigned int s=0; s<numberOfSamples; s++) {
+
+            // Between rounds the pixels whose estimates have converged stop sampling
+            if( adaptiveThreshold > 0.0f && s > 0 && s % adaptiveRoundSamples == 0 ) {
+              unsigned int remainingPixels = 0;
+              for(unsigned int k=0; k<numberOfActivePixels; k++) {
+                const unsigned int i = activePixels[k];
+                const unsigned int x = i % tileWidth;
+                const unsigned int y = i / tileWidth;
+
+                // Variance of the 3x3 neighbourhood within the tile
+                float variance = 0.0f;
+                unsigned int neighbours = 0;
+                for(unsigned int ny = (y > 0 ? y - 1 : 0); ny <= std::min(y + 1, tileHeight - 1); ny++) {
+                  for(unsigned int nx = (x > 0 ? x - 1 : 0); nx <= std::min(x + 1, tileWidth - 1); nx++) {
+                    variance += estimates[ny * tileWidth + nx].getVariance();
+                    neighbours++;
+                  }
+                }
+
+                if( !estimates[i].isConverged(adaptiveThreshold, variance / neighbours) ) {
+                  activePixels[remainingPixels++] = i;
+                }
               }
+              numberOfActivePixels = remainingPixels;
 
-            } else { // If intersecting object is opaque and not a light source
-
-              const glm::vec2 randomAngles = getRandomAngles();
-              
-              if( !shouldTerminateRay(randomAngles.y, probabilityNotToTerminateRay) || node == root ) {
-
-                const glm::vec3 normal = intersection.first->getNormal(intersection.second);
-                const glm::vec3 direction = ray->getDirection();
-                
-                const glm::vec3 directionFlipped = -direction;
-
-                glm::vec2 d1 = {std::acos(directionFlipped.z), 
-                                std::atan2(directionFlipped.y, directionFlipped.x)};
-
-                glm::vec2 normalAngles = {std::acos(normal.z), 
-                                          std::atan2(normal.y, normal.x)};
-
-                const glm::vec2 incomingAngles = d1 - normalAngles;
-                const glm::vec2 outgoingAngles = randomAngles;
-
-                const glm::vec2 reflectionAngles = normalAngles + randomAngles;
-
-                const glm::vec3 reflection = glm::vec3{std::sin(reflectionAngles.x) * std::cos(reflectionAngles.y),
-                                                       std::sin(reflectionAngles.x) * std::sin(reflectionAngles.y),
-                                                       std::cos(reflectionAngles.x)};
-
-                const float importance = node->getImportance();
-
-                const float brdf = dynamic_cast<OpaqueObject*>(intersection.first)->computeBrdf(intersection.second, incomingAngles, outgoingAngles);
-
-                const glm::vec3 newReflectedOrigin = intersection.second + (normal - direction) * getEpsilon();
-
-                const float childImportance = importance * brdf * M_PI;
+              if( numberOfActivePixels == 0 ) {
+                break;
+              }
+            }
 
-                node->setReflected(new Node{new Ray{newReflectedOrigin, reflection}, childImportance, intersection.first, node->getRefractionIndex()});
+            cameraRays.clear();
+            for(unsigned int k=0; k<numberOfActivePixels; k++) {
+              const unsigned int i = activePixels[k];
+              const unsigned int x = tileX + i % tileWidth;
+              const unsigned int y = tileY + i / tileWidth;
+              sequences[k] = RandomSequence{sampler.get(), y * width + x, estimates[i].getNumberOfSamples()};
+              cameraRays.push_back(camera.getRay(rowBases[i / tileWidth], x, sequences[k]));
+            }
 
-                // const glm::vec3 origin = ray->getOrigin();
-                // const glm::vec3 trueReflection = glm::reflect(direction, normal);
-                // std::cout << std::endl;
-                // std::cout << "------------------------" << std::endl;
-                // std::cout << "Root: " << (node == root) << std::endl;
-                // std::cout << "Importance: "  << importance << std::endl;
-                // std::cout << "Origin: "  << origin.x << " " << origin.y << " " << origin.z << std::endl;
-                // std::cout << "Direction: "  << direction.x << " " << direction.y << " " << direction.z << std::endl;
-                // std::cout << "Intersection: "  << intersection.second.x << " " << intersection.second.y << " " << intersection.second.z << std::endl;
-                // std::cout << "Normal: "  << normal.x << " " << normal.y << " " << normal.z << std::endl;
-                // std::cout << "TrueReflection: "  << trueReflection.x << " " << trueReflection.y << " " << trueReflection.z << std::endl;
-                // std::cout << "Reflection: "  << reflection.x << " " << reflection.y << " " << reflection.z << std::endl;
-                // std::string line;
-                // std::getline(std::cin, line);
+            packet.clear();
+            for(unsigned int k=0; k<numberOfActivePixels; k++) {
+              packet.add(&cameraRays[k]);
+            }
+            packet.complete();
 
-                traverse(node->getReflected());
+            const auto primaryRayStartTime = std::chrono::high_resolution_clock::now();
 
-                const glm::vec3 color = intersection.first->getIntensity();
+            if( packetTracing ) {
+              scene.intersect(packet, intersections);
+            } else {
+              for(unsigned int k=0; k<numberOfActivePixels; k++) {
+                intersections[k] = scene.intersect(packet.getRay(k));
+              }
+            }
 
-                const glm::vec3 intensity =  0.5f*(childImportance / (probabilityNotToTerminateRay * importance)) * node->getReflected()->getIntensity()
-                                            + 
-                                          10.0f * scene.castShadowRays(newReflectedOrigin, 
-                                                               incomingAngles, 
-                                                               intersection.first,
-                                                               numberOfShadowRays,
-                                                               normal,
-                                                               normalAngles);
+            const auto primaryRayEndTime = std::chrono::high_resolution_clock::now();
+            primaryRayMicroseconds += std::chrono::duration_cast<std::chrono::microseconds>(primaryRayEndTime - primaryRayStartTime).count();
 
-                node->setIntensity(intensity * color * intersection.first->getColor(intersection.second));
+            for(unsigned int k=0; k<numberOfActivePixels; k++) {
+              glm::vec3 direct;
+              PathIntegrator::FirstSurface surface;
+              const glm::vec3 radiance = integrator.trace(packet.getRay(k), intersections[k], sequences[k], 
+                                                          aovs ? &direct : nullptr, 
+                                                          aovs ? &surface : nullptr);
+              estimates[activePixels[k]].add(radiance);
 
-                delete node->getReflected();
+              if( aovs ) {
+                const unsigned int i = activePixels[k];
+                aovs->add((tileY + i / tileWidth) * width + tileX + i % tileWidth, surface, radiance, direct);
               }
-
             }
+          }
 
-          };
+          for(unsigned int i=0; i<numberOfPixels; i++) {
+            const unsigned int x = tileX + i % tileWidth;
+            const unsigned int y = tileY + i / tileWidth;
 
-          traverse(root);
-        }
+            const glm::vec3 color = estimates[i].getMean();
+            tracedSamples += estimates[i].getNumberOfSamples();
 
-        glm::vec3 color{0.0f, 0.0f, 0.0f};
-        for(unsigned int s=0; s<numberOfSamples; s++) {
-          color += roots[s]->getIntensity();
-          delete roots[s];
-        }
+            localMaxIntensity.r = std::max(localMaxIntensity.r, color.r);
+            localMaxIntensity.g = std::max(localMaxIntensity.g, color.g);
+            localMaxIntensity.b = std::max(localMaxIntensity.b, color.b);
 
-        color /= (float)numberOfSamples;
+            localMinIntensity.r = std::min(localMinIntensity.r, color.r);
+            localMinIntensity.g = std::min(localMinIntensity.g, color.g);
+            localMinIntensity.b = std::min(localMinIntensity.b, color.b);
 
-        const int red = std::min( (int)(std::sqrt(color.r) * 100), 255);
-        const int green = std::min( (int)(std::sqrt(color.g) * 100), 255);
-        const int blue = std::min( (int)(std::sqrt(color.b) * 100), 255);
-        const int alpha = 255;
+            colors[y * width + x] = color;
+            samples[y * width + x] = estimates[i].getNumberOfSamples();
+          }
 
-        localMaxIntensity.r = std::max(localMaxIntensity.r, color.r);
-        localMaxIntensity.g = std::max(localMaxIntensity.g, color.g);
-        localMaxIntensity.b = std::max(localMaxIntensity.b, color.b);
+          update.lock();
+          std::cout << "\r" << (int)((++tileCounter / (float) numberOfTiles) * 100) << "%";
+          std::flush(std::cout);
+          globalMaxIntensity.r = std::max(globalMaxIntensity.r, localMaxIntensity.r);
+          globalMaxIntensity.g = std::max(globalMaxIntensity.g, localMaxIntensity.g);
+          globalMaxIntensity.b = std::max(globalMaxIntensity.b, localMaxIntensity.b);
 
-        localMinIntensity.r = std::min(localMinIntensity.r, color.r);
-        localMinIntensity.g = std::min(localMinIntensity.g, color.g);
-        localMinIntensity.b = std::min(localMinIntensity.b, color.b);
+          globalMinIntensity.r = std::min(globalMinIntensity.r, localMinIntensity.r);
+          globalMinIntensity.g = std::min(globalMinIntensity.g, localMinIntensity.g);
+          globalMinIntensity.b = std::min(globalMinIntensity.b, localMinIntensity.b);
+          update.unlock();
 
-        image[4 * width * y + 4 * x + 0] = red;
-        image[4 * width * y + 4 * x + 1] = green;
-        image[4 * width * y + 4 * x + 2] = blue;
-        image[4 * width * y + 4 * x + 3] = alpha;
+        });
+        threadPool.add(workItem);
       }
+    }
+    threadPool.wait();
+  }
 
-      update.lock();
-      std::cout << "\r" << (int)((++columnCounter / (float) width) * 100) << "%";
-      std::flush(std::cout);
-      globalMaxIntensity.r = std::max(globalMaxIntensity.r, localMaxIntensity.r);
-      globalMaxIntensity.g = std::max(globalMaxIntensity.g, localMaxIntensity.g);
-      globalMaxIntensity.b = std::max(globalMaxIntensity.b, localMaxIntensity.b);
+  const auto renderEndTime = std::chrono::high_resolution_clock::now();
 
-      globalMinIntensity.r = std::min(globalMinIntensity.r, localMinIntensity.r);
-      globalMinIntensity.g = std::min(globalMinIntensity.g, localMinIntensity.g);
-      globalMinIntensity.b = std::min(globalMinIntensity.b, localMinIntensity.b);
-      update.unlock();
+  std::cout << std::endl;
 
-    });
-    threadPool.add(workItem);
+  if( progressive ) {
+    const double renderSeconds = std::chrono::duration_cast<std::chrono::microseconds>(renderEndTime - renderStartTime).count() / 1.0e6;
+    std::cout << "passes: " << progressiveRenderer.getPasses() << " of " << numberOfSamples
+              << " | seconds per pass: " << renderSeconds / std::max(1u, progressiveRenderer.getPasses()) << std::endl;
+  } else if( wavefront ) {
+    const unsigned long long rays = wavefrontIntegrator.getExtendedRays();
+    const double extendSeconds = wavefrontIntegrator.getMicroseconds(WavefrontIntegrator::Stage::EXTEND) / 1.0e6;
+    std::cout << "wavefront ms | generate: " << wavefrontIntegrator.getMicroseconds(WavefrontIntegrator::Stage::GENERATE) / 1000
+              << " | extend: " << wavefrontIntegrator.getMicroseconds(WavefrontIntegrator::Stage::EXTEND) / 1000
+              << " | shade: " << wavefrontIntegrator.getMicroseconds(WavefrontIntegrator::Stage::SHADE) / 1000
+              << " | connect: " << wavefrontIntegrator.getMicroseconds(WavefrontIntegrator::Stage::CONNECT) / 1000
+              << " | compact: " << wavefrontIntegrator.getMicroseconds(WavefrontIntegrator::Stage::COMPACT) / 1000 << std::endl;
+    std::cout << "extended rays: " << rays
+              << " | " << (packetTracing ? "packets" : "single rays")
+              << " | Mrays/s: " << rays / extendSeconds / 1.0e6 << std::endl;
+  } else {
+    const unsigned long long primaryRays = tracedSamples.load();
+    const unsigned long long uniformSamples = (unsigned long long) width * height * numberOfSamples;
+    std::cout << "samples: " << primaryRays << " of " << uniformSamples
+              << " | saved: " << 100.0 * (uniformSamples - primaryRays) / uniformSamples << "%" << std::endl;
+    std::cout << "primary rays: " << primaryRays 
+              << " | " << (packetTracing ? "packets" : "single rays")
+              << " | Mrays/s: " << primaryRays / (primaryRayMicroseconds.load() / 1.0e6) / 1.0e6 << std::endl;
   }
-  threadPool.wait();
 
-  std::cout << std::endl;
+  if( BvhStatistics::isEnabled() ) {
+    const double renderSeconds = std::chrono::duration_cast<std::chrono::microseconds>(renderEndTime - renderStartTime).count() / 1.0e6;
+    // Mesh BVHs are traversed with the width of the scene BVH above them, so their steps add to the rays counted there
+    for(unsigned int i=0; i<BvhStatistics::numberOfWidths; i++) {
+      const unsigned int bvhWidth = BvhStatistics::getWidth(i);
+      const unsigned long long rays = BvhStatistics::getRays(bvhWidth);
+      const unsigned long long steps = BvhStatistics::getTraversalSteps(bvhWidth);
+      if( rays == 0 && steps == 0 ) {
+        continue;
+      }
+      std::cout << "bvh width " << bvhWidth
+                << " | rays: " << rays 
+                << " | traversal steps per ray: " << (rays > 0 ? steps / (double) rays : 0.0)
+                << " | Mrays/s: " << rays / renderSeconds / 1.0e6 << std::endl;
+    }
+  }
   // std::cout << "globalMinIntensity: " << globalMinIntensity.r << " " << globalMinIntensity.g << " " << globalMinIntensity.b << std::endl;
   // std::cout << "globalMaxIntensity: " << globalMaxIntensity.r << " " << globalMaxIntensity.g << " " << globalMaxIntensity.b << std::endl;
 
-  std::string file = config.getValue<std::string>("name");
-  if( argc == 2 ) {
-    file = argv[1];
+  // Optionally compares to a reference image, such as a render with many more samples, 
+  // to tell how many samples the denoiser saves
+  std::vector<unsigned char> reference;
+  if( compareToReference ) {
+    unsigned int referenceWidth;
+    unsigned int referenceHeight;
+    reference = loadImage(config.getValue<std::string>("referenceImage"), referenceWidth, referenceHeight);
+    if( referenceWidth != width || referenceHeight != height ) {
+      throw std::invalid_argument{"The reference image differs in size from the rendered one"};
+    }
+
+    for(unsigned int y=0; y<height; y++) {
+      for(unsigned int x=0; x<width; x++) {
+        writePixel(image, width, x, y, colors[y * width + x]);
+      }
+    }
+    std::cout << "rmse: " << computeRmse(image, reference) << std::endl;
+  }
+
+  if( denoise ) {
+    const auto denoiseStartTime = std::chrono::high_resolution_clock::now();
+    colors = denoiser.denoise(colors, samples, aovs.get());
+    const auto denoiseEndTime = std::chrono::high_resolution_clock::now();
+    std::cout << "denoise ms: " << std::chrono::duration_cast<std::chrono::milliseconds>(denoiseEndTime - denoiseStartTime).count() << std::endl;
+  }
+
+  for(unsigned int y=0; y<height; y++) {
+    for(unsigned int x=0; x<width; x++) {
+      writePixel(image, width, x, y, colors[y * width + x]);
+    }
   }
-  file += ".png";
+
+  if( compareToReference && denoise ) {
+    std::cout << "denoised rmse: " << computeRmse(image, reference) << std::endl;
+  }
+
   outputImage(file, image, width, height);
 
+  if( aovs ) {
+    aovs->write(name);
+  }
+
   const auto endTime = std::chrono::high_resolution_clock::now();
   const unsigned int duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
   std::cout << " | " << file << " | " << duration << " ms" << std::endl;
@@ -1,7 +1,7 @@
 #include "Object.h"
 
 Object::Object(const std::string& name, Mesh* mesh, const bool isTransparent, const bool isLight, const glm::vec3& intensity)
-: name_{name}, mesh_(mesh), isTransparent_(isTransparent), isLight_{isLight}, intensity_{intensity} {
+: name_{name}, mesh_(mesh), isTransparent_(isTransparent), isLight_{isLight}, intensity_{intensity}, id_{0} {
 
 }
 
@@ -9,15 +9,14 @@ Object::~Object() {
   delete mesh_;
 }
 
-std::pair<Object::Intersection, glm::vec3> Object::intersect(const Ray* ray) const {
-  std::tuple<Mesh::Intersection, float, float> intersections = mesh_->getIntersections(ray);
+std::pair<Object::Intersection, HitRecord> Object::intersect(const Ray* ray) const {
+  const std::pair<Mesh::Intersection, HitRecord> intersections = mesh_->getIntersections(ray);
 
-  if (std::get<0>(intersections) == Mesh::Intersection::MISS) {
-    return std::make_pair(Object::Intersection::MISS, glm::vec3{0, 0, 0});
+  if (intersections.first == Mesh::Intersection::MISS) {
+    return std::make_pair(Object::Intersection::MISS, intersections.second);
   }
 
-  glm::vec3 hitLocation = ray->getOrigin() + std::get<1>(intersections) * ray->getDirection();
-  return std::make_pair(Object::Intersection::HIT, hitLocation);
+  return std::make_pair(Object::Intersection::HIT, intersections.second);
 }
 
 
@@ -7,6 +7,7 @@
 #include <glm/glm.hpp>
 
 #include "Ray.h"
+#include "RayPacket.h"
 #include "meshes/Mesh.h"
 
 class Object {
@@ -19,15 +20,24 @@ public:
   bool isTransparent() const { return isTransparent_; }
   bool isLight() const { return isLight_; }
 
-  virtual std::pair<Object::Intersection, glm::vec3> intersect(const Ray* ray) const;
+  virtual std::pair<Object::Intersection, HitRecord> intersect(const Ray* ray) const;
+  virtual unsigned long long intersect(const RayPacket& packet, const unsigned long long rayMask, HitRecord* hits) const { return mesh_->getPacketIntersections(packet, rayMask, hits); }
+  virtual bool occludes(const Ray* ray, const float tMax) const { return mesh_->occludes(ray, tMax); }
 
-  virtual glm::vec3 getNormal(const glm::vec3& position) const { return mesh_->getNormal(position); }
-  virtual glm::vec3 getRandomSurfacePosition() const { return mesh_->getRandomSurfacePosition(); }
-  virtual glm::vec3 getColor(const glm::vec3& position) const { return mesh_->getColor(position); }
+  virtual glm::vec3 getRandomSurfacePosition(const glm::vec2& u, glm::vec3& normal) const { return mesh_->getRandomSurfacePosition(u, normal); }
+  virtual glm::vec3 getColor(const HitRecord& hit) const { return mesh_->getColor(hit); }
   virtual float getArea() const { return mesh_->getArea(); }
+  virtual BoundingBox getBounds() const { return mesh_->getBounds(); }
+  virtual float getNormalCone(glm::vec3& axis) const { return mesh_->getNormalCone(axis); }
   virtual std::string getName() const { return name_; }
   virtual glm::vec3 getIntensity() const { return intensity_; }
 
+  // Index of the object in its scene, set when it is added
+  unsigned int getId() const { return id_; }
+  void setId(const unsigned int id) { id_ = id; }
+
+  virtual void setTransform(const glm::mat4& transform) { mesh_->setTransform(transform); }
+
   virtual void setIntensity(const glm::vec3& intensity);
   virtual void addIntensity(const glm::vec3& intensity);
 
@@ -39,6 +49,7 @@ private:
   const bool isLight_;
   const std::string name_;
   glm::vec3 intensity_;
+  unsigned int id_;
 
 };
 #endif
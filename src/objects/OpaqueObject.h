@@ -10,7 +10,7 @@ public:
   OpaqueObject(const std::string& name, Mesh* mesh, Brdf* brdf, const bool isLight = false, const glm::vec3& intensity = glm::vec3{1.0f, 1.0f, 1.0f});
   virtual ~OpaqueObject();
 
-  float computeBrdf(const glm::vec3& position, const glm::vec2& incoming, const glm::vec2& outgoing) const { return brdf_->compute(position, incoming, outgoing); }
+  float computeBrdf(const glm::vec3& position, const glm::vec3& incoming, const glm::vec3& outgoing) const { return brdf_->compute(position, incoming, outgoing); }
 
 private:
   Brdf* brdf_;
@@ -10,7 +10,9 @@ public:
   Brdf();
   virtual ~Brdf();
 
-  virtual float compute(const glm::vec3& position, const glm::vec2& incoming, const glm::vec2& outgoing) const = 0;
+  // Incoming and outgoing are unit directions away from the surface in the local 
+  // shading frame, where the normal is the z axis
+  virtual float compute(const glm::vec3& position, const glm::vec3& incoming, const glm::vec3& outgoing) const = 0;
 
 private:
 
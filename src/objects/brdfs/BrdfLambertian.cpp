@@ -9,6 +9,6 @@ BrdfLambertian::~BrdfLambertian() {
 
 }
 
-float BrdfLambertian::compute(const glm::vec3& position, const glm::vec2& incoming, const glm::vec2& outgoing) const {
+float BrdfLambertian::compute(const glm::vec3& position, const glm::vec3& incoming, const glm::vec3& outgoing) const {
   return reflectionCoefficient_ / M_PI;
 }
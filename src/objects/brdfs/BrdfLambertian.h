@@ -11,7 +11,7 @@ public:
   BrdfLambertian(float reflectionCoefficient);
   virtual ~BrdfLambertian();
 
-  virtual float compute(const glm::vec3& position, const glm::vec2& incoming, const glm::vec2& outgoing) const override;
+  virtual float compute(const glm::vec3& position, const glm::vec3& incoming, const glm::vec3& outgoing) const override;
 
 protected:
 
@@ -12,11 +12,13 @@ public:
   BrdfOrenNayar(float reflectionCoefficient, float deviation);
   virtual ~BrdfOrenNayar();
 
-  virtual float compute(const glm::vec3& position, const glm::vec2& incoming, const glm::vec2& outgoing) const override;
+  virtual float compute(const glm::vec3& position, const glm::vec3& incoming, const glm::vec3& outgoing) const override;
 protected:
 
 private:
   float reflectionCoefficient_;
   float deviation_;
+  float a_;
+  float b_;
 };
 #endif
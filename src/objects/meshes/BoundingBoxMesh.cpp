@@ -15,18 +15,24 @@ BoundingBoxMesh::~BoundingBoxMesh() {
   delete bitmap_;
 }
 
-glm::vec3 BoundingBoxMesh::getNormal(const glm::vec3& position) const {
-  return -1.0f * BoxMesh::getNormal(position);
+std::pair<Mesh::Intersection, HitRecord> BoundingBoxMesh::getIntersections(const Ray* ray) const {
+  std::pair<Mesh::Intersection, HitRecord> intersection = BoxMesh::getIntersections(ray);
+  intersection.second.normal = -1.0f * intersection.second.normal;
+  intersection.second.shadingNormal = intersection.second.normal;
+  return intersection;
 }
 
 
-glm::vec3 BoundingBoxMesh::getColor(const glm::vec3& position) const {
+glm::vec3 BoundingBoxMesh::getColor(const HitRecord& hit) const {
 
-  if( equalsEpsilon(position.z, zLimits_.y) ) {
+  const glm::vec3& position = hit.position;
+
+  // Faces are numbered -x, +x, -y, +y, -z, +z as in BoxMesh
+  if( hit.primitive == 5 ) {
     return glm::vec3(0.5f, 0.8f, 0.5f);
   }
 
-  if( equalsEpsilon(position.x, xLimits_.x) ) {
+  if( hit.primitive == 0 ) {
     glm::vec2 len{zLimits_.y - zLimits_.x, 
                   yLimits_.y - yLimits_.x};
 
@@ -66,11 +72,11 @@ glm::vec3 BoundingBoxMesh::getColor(const glm::vec3& position) const {
     // return glm::vec3(0.1f, 0.12f, 1.0f);
   }
 
-  if( equalsEpsilon(position.x, xLimits_.y) ) {
+  if( hit.primitive == 1 ) {
     return glm::vec3(1.0f, 0.1f, 0.12f);
   }
 
-  if( equalsEpsilon(position.y, yLimits_.x) ) {
+  if( hit.primitive == 2 ) {
     // glm::vec2 len{zLimits_.y - zLimits_.x, xLimits_.y - xLimits_.x};
     // glm::vec2 uv{(position.z / len.x), (position.x / len.y)};
     const glm::vec3 color1 = glm::vec3{0.9f, 0.9, 0.9f};
@@ -78,7 +84,7 @@ glm::vec3 BoundingBoxMesh::getColor(const glm::vec3& position) const {
     return checker(position, color1, color2);
   }
 
-  if( equalsEpsilon(position.y, yLimits_.y) ) {
+  if( hit.primitive == 3 ) {
     return glm::vec3(1.0f, 0.968627451f, 0.8f);
   }
 
@@ -16,9 +16,9 @@ public:
 
   ~BoundingBoxMesh();
 
-  virtual glm::vec3 getNormal(const glm::vec3& position) const override;
+  std::pair<Mesh::Intersection, HitRecord> getIntersections(const Ray* ray) const override;
 
-  virtual glm::vec3 getColor(const glm::vec3& position) const override;
+  virtual glm::vec3 getColor(const HitRecord& hit) const override;
   
 private:
   Bitmap* bitmap_;
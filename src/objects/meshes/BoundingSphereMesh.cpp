@@ -1,5 +1,8 @@
 #include "BoundingSphereMesh.h"
 
-glm::vec3 BoundingSphereMesh::getNormal(const glm::vec3& position) const {
-  return -1.0f * SphereMesh::getNormal(position);
+std::pair<Mesh::Intersection, HitRecord> BoundingSphereMesh::getIntersections(const Ray* ray) const {
+  std::pair<Mesh::Intersection, HitRecord> intersection = SphereMesh::getIntersections(ray);
+  intersection.second.normal = -1.0f * intersection.second.normal;
+  intersection.second.shadingNormal = intersection.second.normal;
+  return intersection;
 }
@@ -7,7 +7,7 @@ class BoundingSphereMesh : public SphereMesh{
 public:
   using SphereMesh::SphereMesh;
 
-  virtual glm::vec3 getNormal(const glm::vec3& position) const override;
+  std::pair<Mesh::Intersection, HitRecord> getIntersections(const Ray* ray) const override;
 
 protected:
 
@@ -10,87 +10,101 @@ BoxMesh::BoxMesh(const glm::vec2 xLimits, const glm::vec2 yLimits, const glm::ve
 }
 
 
-std::tuple<Mesh::Intersection, float, float> BoxMesh::getIntersections(const Ray* ray) const {
+std::pair<Mesh::Intersection, HitRecord> BoxMesh::getIntersections(const Ray* ray) const {
 
   const glm::vec3 origin = ray->getOrigin();
   const glm::vec3 inversedDirection = ray->getInversedDirection();
 
-
+  // The faces are numbered -x, +x, -y, +y, -z, +z. The face a slab is entered 
+  // through depends on the sign of the direction along that axis.
   const double tx1 = (xLimits_.x - origin.x) * inversedDirection.x;
   const double tx2 = (xLimits_.y - origin.x) * inversedDirection.x;
 
   double sMin = tx1 < tx2 ? tx1 : tx2;
   double sMax = tx1 > tx2 ? tx1 : tx2;
+  unsigned int sMinFace = tx1 < tx2 ? 0 : 1;
+  unsigned int sMaxFace = tx1 > tx2 ? 0 : 1;
 
   const double ty1 = (yLimits_.x - origin.y) * inversedDirection.y;
   const double ty2 = (yLimits_.y - origin.y) * inversedDirection.y;
 
-  sMin = sMin > (ty1 < ty2 ? ty1 : ty2) ? sMin : (ty1 < ty2 ? ty1 : ty2);
-  sMax = sMax < (ty1 > ty2 ? ty1 : ty2) ? sMax : (ty1 > ty2 ? ty1 : ty2);
+  if( sMin < (ty1 < ty2 ? ty1 : ty2) ) {
+    sMin = ty1 < ty2 ? ty1 : ty2;
+    sMinFace = ty1 < ty2 ? 2 : 3;
+  }
+  if( sMax > (ty1 > ty2 ? ty1 : ty2) ) {
+    sMax = ty1 > ty2 ? ty1 : ty2;
+    sMaxFace = ty1 > ty2 ? 2 : 3;
+  }
 
   const double tz1 = (zLimits_.x - origin.z) * inversedDirection.z;
   const double tz2 = (zLimits_.y - origin.z) * inversedDirection.z;
 
-  sMin = sMin > (tz1 < tz2 ? tz1 : tz2) ? sMin : (tz1 < tz2 ? tz1 : tz2);
-  sMax = sMax < (tz1 > tz2 ? tz1 : tz2) ? sMax : (tz1 > tz2 ? tz1 : tz2);
+  if( sMin < (tz1 < tz2 ? tz1 : tz2) ) {
+    sMin = tz1 < tz2 ? tz1 : tz2;
+    sMinFace = tz1 < tz2 ? 4 : 5;
+  }
+  if( sMax > (tz1 > tz2 ? tz1 : tz2) ) {
+    sMax = tz1 > tz2 ? tz1 : tz2;
+    sMaxFace = tz1 > tz2 ? 4 : 5;
+  }
 
   const bool hit = sMax >= (0.0 > sMin ? 0.0 : sMin);
 
   if( hit && sMin < 0 && sMax > 0) {
     // Innuti
-    // std::cout << "Innuti" << std::endl;
-
-    return std::make_tuple(Mesh::Intersection::DOUBLE_HIT, sMax, sMin);
+    return std::make_pair(Mesh::Intersection::DOUBLE_HIT, getHitRecord(ray, sMax, sMaxFace));
   }
 
   if( hit && sMin > 0 && sMax > 0 ) {
     // Boxen framför oss
-    // std::cout << "Framfor" << std::endl;
-
-    return std::make_tuple(Mesh::Intersection::DOUBLE_HIT, sMin, sMax);
+    return std::make_pair(Mesh::Intersection::DOUBLE_HIT, getHitRecord(ray, sMin, sMinFace));
   }
 
-    // std::cout << "BAKOm" << std::endl;
-
-  // if( sMin < 0 && sMax < 0 ) {
-    // Boxen bakom oss
-    return std::make_tuple(Mesh::Intersection::MISS, sMin, sMax);
-  // }
+  // Boxen bakom oss
+  return std::make_pair(Mesh::Intersection::MISS, HitRecord{});
 
 }
 
 
-glm::vec3 BoxMesh::getNormal(const glm::vec3& position) const {
-
-  // Bakom
-  if( equalsEpsilon(position.x, xLimits_.x) ) {
-    return glm::vec3(-1.0f, 0.0f, 0.0f);
+bool BoxMesh::occludes(const Ray* ray, const float tMax) const {
+  float tNear;
+  if( !getBounds().intersect(ray->getOrigin(), ray->getInversedDirection(), tMax, tNear) ) {
+    return false;
   }
 
-  // Framfor
-  if ( equalsEpsilon(position.x, xLimits_.y) ) {
-    return glm::vec3(1.0f, 0.0f, 0.0f);
+  if( tNear > 0.0f ) {
+    return true;
   }
 
-  // Hoger
-  if( equalsEpsilon(position.y, yLimits_.x) ) {
-    return glm::vec3(0.0f, -1.0f, 0.0f);
-  }
+  // The ray starts inside the box, it is blocked if it leaves the box before tMax
+  const glm::vec3 origin = ray->getOrigin();
+  const glm::vec3 inversedDirection = ray->getInversedDirection();
+  const glm::vec3 t1 = (glm::vec3{xLimits_.x, yLimits_.x, zLimits_.x} - origin) * inversedDirection;
+  const glm::vec3 t2 = (glm::vec3{xLimits_.y, yLimits_.y, zLimits_.y} - origin) * inversedDirection;
+  const float sMax = std::min(std::min(std::max(t1.x, t2.x), std::max(t1.y, t2.y)), std::max(t1.z, t2.z));
 
-  // Vänster
-  if( equalsEpsilon(position.y, yLimits_.y) ) {
-    return glm::vec3(0.0f, 1.0f, 0.0f);
-  }
+  return sMax < tMax;
+}
 
-  // Undre
-  if( equalsEpsilon(position.z, zLimits_.x) ) {
-    return glm::vec3(0.0f, 0.0f, -1.0f);
-  }
 
-  // ÖVre
-  if( equalsEpsilon(position.z, zLimits_.y) ) {
-    return glm::vec3(0.0f, 0.0f, 1.0f);
-  }
+HitRecord BoxMesh::getHitRecord(const Ray* ray, const float t, const unsigned int face) const {
+  static const glm::vec3 faceNormals[6] = {glm::vec3{-1.0f, 0.0f, 0.0f}, glm::vec3{1.0f, 0.0f, 0.0f},
+                                           glm::vec3{0.0f, -1.0f, 0.0f}, glm::vec3{0.0f, 1.0f, 0.0f},
+                                           glm::vec3{0.0f, 0.0f, -1.0f}, glm::vec3{0.0f, 0.0f, 1.0f}};
+  HitRecord hit;
+  hit.t = t;
+  hit.primitive = face;
+  hit.barycentrics = glm::vec2{0.0f, 0.0f};
+  hit.position = ray->getOrigin() + t * ray->getDirection();
+  hit.normal = faceNormals[face];
+  hit.shadingNormal = hit.normal;
+  return hit;
+}
 
-  throw std::invalid_argument{"The given position is not on the surface of the BoxMesh."};
+
+BoundingBox BoxMesh::getBounds() const {
+  return BoundingBox{glm::vec3{xLimits_.x, yLimits_.x, zLimits_.x}, 
+                     glm::vec3{xLimits_.y, yLimits_.y, zLimits_.y}};
 }
+
@@ -16,11 +16,14 @@ class BoxMesh : public Mesh {
 public:
   BoxMesh(const glm::vec2 xLimits, const glm::vec2 yLimits, const glm::vec2 zLimits);
 
-  std::tuple<Mesh::Intersection, float, float> getIntersections(const Ray* ray) const override;
-  
-  virtual glm::vec3 getNormal(const glm::vec3& position) const override;
+  std::pair<Mesh::Intersection, HitRecord> getIntersections(const Ray* ray) const override;
+  bool occludes(const Ray* ray, const float tMax) const override;
+
+  BoundingBox getBounds() const override;
 
 protected:
+  HitRecord getHitRecord(const Ray* ray, const float t, const unsigned int face) const;
+
   const glm::vec2 xLimits_;
   const glm::vec2 yLimits_;
   const glm::vec2 zLimits_;
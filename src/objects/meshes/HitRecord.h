@@ -0,0 +1,19 @@
+#ifndef HITRECORD_H
+#define HITRECORD_H
+
+#include "glm/glm.hpp"
+
+
+// Everything shading needs to know about a hit, filled in once by the mesh 
+// that was intersected so that the surface never has to be searched again.
+struct HitRecord {
+  float t;
+  unsigned int primitive;    // Triangle index for triangle meshes, face index for boxes
+  glm::vec2 barycentrics;    // Barycentric coordinates of the hit within the primitive
+  glm::vec3 position;
+  glm::vec3 normal;          // Geometric normal
+  glm::vec3 shadingNormal;   // Interpolated vertex normal when the mesh has one, otherwise the geometric normal
+};
+
+
+#endif // HITRECORD_H
@@ -9,19 +9,26 @@ Mesh::~Mesh(){
 }
 
 
-std::tuple<Mesh::Intersection, glm::vec3, glm::vec3> Mesh::hit(const Ray* ray) const {
-  
-  std::tuple<Mesh::Intersection, float, float> intersections = getIntersections(ray);
+bool Mesh::occludes(const Ray* ray, const float tMax) const {
+  const std::pair<Mesh::Intersection, HitRecord> intersection = getIntersections(ray);
+  return intersection.first != Mesh::Intersection::MISS && intersection.second.t > 0.0f && intersection.second.t < tMax;
+}
+
 
-  glm::vec3 intersection{0.0f, 0.0f, 0.0f};
-  glm::vec3 normal{0.0f, 0.0f, 0.0f};
+unsigned long long Mesh::getPacketIntersections(const RayPacket& packet, const unsigned long long rayMask, HitRecord* hits) const {
+  unsigned long long hitMask = 0;
 
-  if( std::get<0>(intersections) == Mesh::Intersection::MISS ) {
-   return std::make_tuple(Mesh::Intersection::MISS, intersection, normal);
+  for(unsigned int i=0; i<packet.getSize(); i++) {
+    const unsigned long long bit = 1ull << i;
+    if( rayMask & bit ) {
+      const std::pair<Mesh::Intersection, HitRecord> intersection = getIntersections(packet.getRay(i));
+      if( intersection.first != Mesh::Intersection::MISS ) {
+        hits[i] = intersection.second;
+        hitMask |= bit;
+      }
+    }
   }
 
-  intersection = ray->getOrigin() + std::get<1>(intersections) * ray->getDirection();
-  normal = getNormal(intersection);
-  
-  return std::make_tuple(Mesh::Intersection::SINGLE_HIT, intersection, normal);
+  return hitMask;
 }
+
@@ -1,12 +1,16 @@
 #ifndef MESH_H
 #define MESH_H
 
-#include <tuple>
+#include <utility>
 #include <stdexcept>
+#include <cmath>
 
 #include <glm/glm.hpp>
 
 #include "Ray.h"
+#include "RayPacket.h"
+#include "HitRecord.h"
+#include "acceleration/BoundingBox.h"
 
 
 class Mesh {
@@ -16,14 +20,23 @@ public:
   Mesh();
   virtual ~Mesh() = 0;
 
-  virtual std::tuple<Mesh::Intersection, float, float> getIntersections(const Ray* ray) const = 0;
-  virtual std::tuple<Mesh::Intersection, glm::vec3, glm::vec3> hit(const Ray* ray) const;
+  virtual std::pair<Mesh::Intersection, HitRecord> getIntersections(const Ray* ray) const = 0;
+  virtual bool occludes(const Ray* ray, const float tMax) const;
 
-  virtual glm::vec3 getNormal(const glm::vec3& position) const = 0;
-  virtual glm::vec3 getRandomSurfacePosition() const { throw std::invalid_argument{"getRandomSurfacePosition() not implemented"};
-                                                       return glm::vec3{0,0,0}; }
+  // Intersects the rays of the packet in rayMask, fills in hits for the rays that 
+  // hit the mesh and returns them. Meshes with their own hierarchy trace the packet 
+  // through it, the default intersects one ray at a time.
+  virtual unsigned long long getPacketIntersections(const RayPacket& packet, const unsigned long long rayMask, HitRecord* hits) const;
+
+  virtual BoundingBox getBounds() const = 0;
+  // Point on the surface for u uniform in [0, 1)^2, uniformly distributed over its area
+  virtual glm::vec3 getRandomSurfacePosition(const glm::vec2& /*u*/, glm::vec3& /*normal*/) const { throw std::invalid_argument{"getRandomSurfacePosition() not implemented"};
+                                                                                            return glm::vec3{0,0,0}; }
   virtual float getArea() const { throw std::invalid_argument{"getArea() not implemented"}; return 1.0f; }
-  virtual glm::vec3 getColor(const glm::vec3& position) const { return glm::vec3{1.0f, 1.0f, 1.0f}; }
+  virtual glm::vec3 getColor(const HitRecord& hit) const { return glm::vec3{1.0f, 1.0f, 1.0f}; }
+  // Half angle of the cone around axis that holds the surface normals, the default holds all of them
+  virtual float getNormalCone(glm::vec3& axis) const { axis = glm::vec3{0.0f, 0.0f, 1.0f}; return M_PI; }
+  virtual void setTransform(const glm::mat4& /*transform*/) { throw std::invalid_argument{"setTransform() not implemented"}; }
 
 private:
 
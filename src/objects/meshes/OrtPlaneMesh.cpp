@@ -34,20 +34,17 @@ OrtPlaneMesh::OrtPlaneMesh(const glm::vec3 upperLeftCorner,
 }
 
 
-std::tuple<Mesh::Intersection, float, float> OrtPlaneMesh::getIntersections(const Ray* ray) const {
+std::pair<Mesh::Intersection, HitRecord> OrtPlaneMesh::getIntersections(const Ray* ray) const {
 
   const glm::vec3 origin = ray->getOrigin();
   const glm::vec3 direction = ray->getDirection();
 
-  float sMin = 0.0f;
-  float sMax = 1.0f;
-    
   // if( equalsEpsilon(glm::dot(normal_, direction), 0.0f) ) { // Perpendicular ray
-  //   return std::make_tuple(Mesh::Intersection::MISS, sMin, sMax);
+  //   return std::make_pair(Mesh::Intersection::MISS, HitRecord{});
   // }
    
   if( glm::dot(normal_, -direction) <= getEpsilon() ) { // Backface culling
-    return std::make_tuple(Mesh::Intersection::MISS, sMin, sMax);
+    return std::make_pair(Mesh::Intersection::MISS, HitRecord{});
   }
 
   // const glm::vec3 p0 = origin;
@@ -61,7 +58,7 @@ std::tuple<Mesh::Intersection, float, float> OrtPlaneMesh::getIntersections(cons
   const float t = (glm::dot(normal_, center_-origin) / glm::dot(normal_, direction));
 
   if( t <= 0 ) {
-    return std::make_tuple(Mesh::Intersection::MISS, sMin, sMax);
+    return std::make_pair(Mesh::Intersection::MISS, HitRecord{});
   }
 
   const glm::vec3 point = origin + t * (direction);
@@ -78,11 +75,19 @@ std::tuple<Mesh::Intersection, float, float> OrtPlaneMesh::getIntersections(cons
     // std::cout << "direction: " << direction.x << " " << direction.y << " " << direction.z << std::endl;
     // std::cout << "point: " << point.x << " " << point.y << " " << point.z << std::endl;
 
-    return std::make_tuple(Mesh::Intersection::SINGLE_HIT, t, sMax);
+    HitRecord hit;
+    hit.t = t;
+    hit.primitive = 0;
+    hit.barycentrics = glm::vec2{0.0f, 0.0f};
+    hit.position = point;
+    hit.normal = normal_;
+    hit.shadingNormal = normal_;
+
+    return std::make_pair(Mesh::Intersection::SINGLE_HIT, hit);
   }
 
   // std::cout << "MISS!" << std::endl;
-  return std::make_tuple(Mesh::Intersection::MISS, sMin, sMax);
+  return std::make_pair(Mesh::Intersection::MISS, HitRecord{});
 
 
   // http://www.xbdev.net/maths_of_3d/collision_detection/line_with_plane/index.php
@@ -110,12 +115,35 @@ std::tuple<Mesh::Intersection, float, float> OrtPlaneMesh::getIntersections(cons
 }
 
 
-glm::vec3 OrtPlaneMesh::getNormal(const glm::vec3& position) const {
-  return normal_;
+bool OrtPlaneMesh::occludes(const Ray* ray, const float tMax) const {
+  const glm::vec3 direction = ray->getDirection();
+
+  if( glm::dot(normal_, -direction) <= getEpsilon() ) { // Backface culling
+    return false;
+  }
+
+  const glm::vec3 origin = ray->getOrigin();
+  const float t = (glm::dot(normal_, center_-origin) / glm::dot(normal_, direction));
+
+  if( t <= 0 || t >= tMax ) {
+    return false;
+  }
+
+  const glm::vec3 point = origin + t * (direction);
+
+  return (xLimits_.x <= point.x) && (point.x <= xLimits_.y) &&
+         (yLimits_.x <= point.y) && (point.y <= yLimits_.y) &&
+         (zLimits_.x <= point.z) && (point.z <= zLimits_.y);
+}
+
+glm::vec3 OrtPlaneMesh::getRandomSurfacePosition(const glm::vec2& u, glm::vec3& normal) const {
+  normal = normal_;
+  return lowerLeftCorner_ + u.x * edge3_ + u.y * edge4_;
 }
 
-glm::vec3 OrtPlaneMesh::getRandomSurfacePosition() const {
-  return lowerLeftCorner_ + random0To1() * edge3_ + random0To1() * edge4_;
+BoundingBox OrtPlaneMesh::getBounds() const {
+  return BoundingBox{glm::vec3{xLimits_.x, yLimits_.x, zLimits_.x}, 
+                     glm::vec3{xLimits_.y, yLimits_.y, zLimits_.y}};
 }
 
 float OrtPlaneMesh::getArea() const {
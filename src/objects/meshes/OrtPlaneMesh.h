@@ -19,10 +19,12 @@ public:
                const glm::vec3 lowerLeftCorner,
                const glm::vec3 lowerRightCorner);
 
-  std::tuple<Mesh::Intersection, float, float> getIntersections(const Ray* ray) const override;
-  glm::vec3 getNormal(const glm::vec3& position) const override;
-  glm::vec3 getRandomSurfacePosition() const override;
+  std::pair<Mesh::Intersection, HitRecord> getIntersections(const Ray* ray) const override;
+  bool occludes(const Ray* ray, const float tMax) const override;
+  glm::vec3 getRandomSurfacePosition(const glm::vec2& u, glm::vec3& normal) const override;
   float getArea() const override;
+  BoundingBox getBounds() const override;
+  float getNormalCone(glm::vec3& axis) const override { axis = normal_; return 0.0f; }
 
 
 protected:
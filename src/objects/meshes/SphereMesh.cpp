@@ -12,7 +12,7 @@ SphereMesh::~SphereMesh() {
 
 }
 
-std::tuple<Mesh::Intersection, float, float> SphereMesh::getIntersections(const Ray* ray) const {
+std::pair<Mesh::Intersection, HitRecord> SphereMesh::getIntersections(const Ray* ray) const {
     const glm::vec3 c = position_;
     const glm::vec3 o = ray->getOrigin();
     const glm::vec3 d = ray->getDirection();
@@ -30,7 +30,7 @@ std::tuple<Mesh::Intersection, float, float> SphereMesh::getIntersections(const
 
     if (numeratorSecondPart == 0.0) {
       sMin = numeratorFirstPart / denominator;
-      return std::make_tuple(Mesh::Intersection::SINGLE_HIT, sMin, sMax);
+      return std::make_pair(Mesh::Intersection::SINGLE_HIT, getHitRecord(ray, sMin));
 
     } else if(numeratorSecondPart > 0) {
 
@@ -43,29 +43,57 @@ std::tuple<Mesh::Intersection, float, float> SphereMesh::getIntersections(const
       // std::cout << "Smax: " << sMax << std::endl;
 
       if (sMax < 0) {
-        return std::make_tuple(Mesh::Intersection::MISS, sMax, sMin);
+        return std::make_pair(Mesh::Intersection::MISS, HitRecord{});
       }else {
         if (sMin < 0) {
-          return std::make_tuple(Mesh::Intersection::DOUBLE_HIT, sMax, sMin);
+          return std::make_pair(Mesh::Intersection::DOUBLE_HIT, getHitRecord(ray, sMax));
         } else {
-          return std::make_tuple(Mesh::Intersection::DOUBLE_HIT, sMin, sMax);
+          return std::make_pair(Mesh::Intersection::DOUBLE_HIT, getHitRecord(ray, sMin));
         }
       }
 
     }
 
-    return std::make_tuple(Mesh::Intersection::MISS, sMin, sMax);
+    return std::make_pair(Mesh::Intersection::MISS, HitRecord{});
 }
 
-glm::vec3 SphereMesh::getNormal(const glm::vec3& position) const {
-  return glm::normalize(position - position_);
+bool SphereMesh::occludes(const Ray* ray, const float tMax) const {
+  const glm::vec3 d = ray->getDirection();
+  const glm::vec3 oMinusC = ray->getOrigin() - position_;
+
+  const float a = glm::dot(d, d);
+  const float b = glm::dot(d, oMinusC);
+  const float discriminant = b * b - a * (glm::dot(oMinusC, oMinusC) - radiusPow2_);
+
+  if( discriminant < 0.0f ) {
+    return false;
+  }
+
+  const float sqrtDiscriminant = std::sqrt(discriminant);
+  const float sMin = (-b - sqrtDiscriminant) / a;
+  const float sMax = (-b + sqrtDiscriminant) / a;
+
+  return (sMin > 0.0f && sMin < tMax) || (sMin <= 0.0f && sMax > 0.0f && sMax < tMax);
 }
 
-glm::vec3 SphereMesh::getRandomSurfacePosition() const {
-  const glm::vec2 randomAngles = getRandomAngles();
+HitRecord SphereMesh::getHitRecord(const Ray* ray, const float t) const {
+  HitRecord hit;
+  hit.t = t;
+  hit.primitive = 0;
+  hit.barycentrics = glm::vec2{0.0f, 0.0f};
+  hit.position = ray->getOrigin() + t * ray->getDirection();
+  hit.normal = glm::normalize(hit.position - position_);
+  hit.shadingNormal = hit.normal;
+  return hit;
+}
+
+BoundingBox SphereMesh::getBounds() const {
+  return BoundingBox{position_ - glm::vec3{radius_}, position_ + glm::vec3{radius_}};
+}
 
-  const glm::vec3 position = glm::vec3{radius_ * std::sin(randomAngles.x) * std::cos(randomAngles.y),
-                                       radius_ * std::sin(randomAngles.x) * std::sin(randomAngles.y),
-                                       radius_ * std::cos(randomAngles.x)};
-  return position_ + position;
+glm::vec3 SphereMesh::getRandomSurfacePosition(const glm::vec2& u, glm::vec3& normal) const {
+  // Uniform over the whole surface, with the density of one over the area that the 
+  // shadow rays divide by
+  normal = getRandomSphereVector(u);
+  return position_ + radius_ * normal;
 }
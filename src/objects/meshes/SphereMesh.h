@@ -18,12 +18,16 @@ public:
   SphereMesh(const glm::vec3 position, const float radius);
   ~SphereMesh();
 
-  std::tuple<Mesh::Intersection, float, float> getIntersections(const Ray* ray) const override;
-  glm::vec3 getNormal(const glm::vec3& position) const override;
-  glm::vec3 getRandomSurfacePosition() const override;
+  std::pair<Mesh::Intersection, HitRecord> getIntersections(const Ray* ray) const override;
+  bool occludes(const Ray* ray, const float tMax) const override;
+  glm::vec3 getRandomSurfacePosition(const glm::vec2& u, glm::vec3& normal) const override;
   float getArea() const override { return area_; }
+  BoundingBox getBounds() const override;
 
 
+protected:
+  HitRecord getHitRecord(const Ray* ray, const float t) const;
+
 private:
   const glm::vec3 position_;
   const float radius_;
@@ -1,200 +1,212 @@
 #include "TriangleMesh.h"
 
-TriangleMesh::TriangleMesh(const std::vector<glm::vec3> verticies, const std::vector<glm::vec3> normals) 
-: verticies_{verticies}, normals_{normals}, hasNormals_{!normals.empty()}
+TriangleMesh::TriangleMesh(const std::vector<glm::vec3> verticies, const std::vector<glm::vec3> normals, ThreadPool* threadPool) 
+: verticies_{verticies}, normals_{normals}, hasNormals_{!normals.empty()}, transform_{1.0f}, threadPool_{threadPool}
 {
-
+  bvh_.build(computeTriangleBounds(), threadPool_);
+  buildTriangleBlocks();
 }
 
 
-std::tuple<Mesh::Intersection, float, float> TriangleMesh::getIntersections(const Ray* ray) const {
-
-  const glm::vec3 origin = ray->getOrigin();
-  
-  bool hit = false;
-  float nearestHitDistance{std::numeric_limits<float>::max()};
-  glm::vec3 nearestHit;
-  float nearestT = 0.5f;
-
-  for(unsigned int i=0; i<verticies_.size(); i+=3) {
-    glm::vec3 intersection;
-    glm::vec3 normal;
-    float t;
-    bool intersects = triangleIntersection(ray, verticies_[i], verticies_[i+1], verticies_[i+2], intersection, normal, t);
-
-    if( intersects ) {
-      float distance = glm::distance(intersection, origin);
-      if( distance < nearestHitDistance ) {
-        nearestHit = intersection;
-        hit = true;
-        nearestT = t;
-        nearestHitDistance = distance;
-      }
-    }
+void TriangleMesh::setTransform(const glm::mat4& transform) {
+  if( objectVerticies_.empty() ) {
+    objectVerticies_ = verticies_;
+    objectNormals_ = normals_;
   }
+  transform_ = transform;
+  update();
+}
 
-  float sMin = 0.5f; // TODO: FIX!
-  float sMax = 1.0f;
 
-  if( hit ) {
-    return std::make_tuple(Mesh::Intersection::SINGLE_HIT, nearestT, sMax);
+void TriangleMesh::setVerticies(const std::vector<glm::vec3>& verticies, const std::vector<glm::vec3>& normals) {
+  if( verticies.size() != verticies_.size() ) {
+    throw std::invalid_argument{"setVerticies() can not change the number of verticies."};
   }
+  if( hasNormals_ && !normals.empty() && normals.size() != verticies.size() ) {
+    throw std::invalid_argument{"setVerticies() needs one normal per vertex."};
+  }
+  if( objectVerticies_.empty() ) {
+    objectNormals_ = normals_;
+  }
+  if( hasNormals_ && !normals.empty() ) {
+    objectNormals_ = normals;
+  }
+  objectVerticies_ = verticies;
+  update();
+}
 
-  return std::make_tuple(Mesh::Intersection::MISS, nearestT, sMax);
 
-}
+void TriangleMesh::update() {
+  const glm::mat3 normalTransform = glm::transpose(glm::inverse(glm::mat3{transform_}));
 
+  for(unsigned int i=0; i<verticies_.size(); i++) {
+    const glm::vec4 vertex = transform_ * glm::vec4{objectVerticies_[i], 1.0f};
+    verticies_[i] = glm::vec3{vertex.x, vertex.y, vertex.z};
+  }
 
-glm::vec3 TriangleMesh::getNormal(const glm::vec3& position) const {
+  if( hasNormals_ ) {
+    for(unsigned int i=0; i<normals_.size(); i++) {
+      normals_[i] = glm::normalize(normalTransform * objectNormals_[i]);
+    }
+  }
 
-  for(unsigned int i=0; i<verticies_.size(); i+=3) {
-    glm::vec3 p1 = verticies_[i];
-    glm::vec3 p2 = verticies_[i+1];
-    glm::vec3 p3 = verticies_[i+2];
+  // A rebuild may have reordered the triangles, and the blocks hold the old positions either way
+  bvh_.refit(computeTriangleBounds(), threadPool_);
+  buildTriangleBlocks();
+}
 
-    glm::vec3 u = p2 - p1;
-    glm::vec3 v = p3 - p1;
-    glm::vec3 w = position - p1;
-    glm::vec3 n = glm::cross(u, v);
-    float nSquared = glm::dot(n, n);
 
-    float gamma = glm::dot(glm::cross(u, w), n) / nSquared;
-    float beta = glm::dot(glm::cross(w, v), n) / nSquared;
-    float alfa = 1.0f - gamma - beta;
+std::vector<BoundingBox> TriangleMesh::computeTriangleBounds() const {
+  std::vector<BoundingBox> triangleBounds;
+  triangleBounds.reserve(verticies_.size() / 3);
 
-    // glm::vec3 projectedPoint = alfa * p1 + beta * p2 + gamma * p3;
+  for(unsigned int i=0; i+2<verticies_.size(); i+=3) {
+    BoundingBox bounds{verticies_[i], verticies_[i]};
+    bounds.expand(verticies_[i+1]);
+    bounds.expand(verticies_[i+2]);
+    triangleBounds.push_back(bounds);
+  }
 
-    if( (-getEpsilon() + 0.0f <= alfa && alfa <= 1.0f + getEpsilon()) && 
-        (-getEpsilon() + 0.0f <= beta && beta <= 1.0f + getEpsilon()) && 
-        (-getEpsilon() + 0.0f <= gamma && gamma <= 1.0f + getEpsilon()) ) {
+  return triangleBounds;
+}
 
-      if( hasNormals_ ) {
-        return normals_[i];
-      } else {
-        return glm::normalize(n);
-      }
-    }
 
-  }
+void TriangleMesh::buildTriangleBlocks() {
+  const std::vector<unsigned int>& triangles = bvh_.getPrimitiveIndices();
+  triangleBlocks_.clear();
+  leafBlocks_.assign(triangles.size(), 0);
 
-  // std::cout << "eh" << std::endl;
-
-  for(unsigned int i=0; i<verticies_.size(); i+=3) {
-    const bool b1 = sign(position, verticies_[i], verticies_[i+1]) < 0.0f;
-    const bool b2 = sign(position, verticies_[i+1], verticies_[i+2]) < 0.0f;
-    const bool b3 = sign(position, verticies_[i+2], verticies_[i]) < 0.0f;
-
-    if( (b1 == b2) && (b2 == b3) ) {
-      // std::cout << "AA" << std::endl;
-      glm::vec3 edge1 = verticies_[i+1] - verticies_[i];
-      glm::vec3 edge2 = verticies_[i+2] - verticies_[i]; 
-      if( hasNormals_ ) {
-        return normals_[i];
-      } else {
-        return glm::normalize(glm::cross(edge1, edge2));
-      }
+  for(const BvhNode& node : bvh_.getNodes()) {
+    if( !node.isLeaf() ) {
+      continue;
     }
-  }
 
-  for(unsigned int i=0; i<verticies_.size(); i+=3) {
-   
-    const glm::vec3 v0 = verticies_[i+1] - verticies_[i];
-    const glm::vec3 v1 = verticies_[i+2] - verticies_[i];
-    const glm::vec3 v2 = position - verticies_[i];
-
-    // Compute dot products
-    const float dot00 = glm::dot(v0, v0);
-    const float dot01 = glm::dot(v0, v1);
-    const float dot02 = glm::dot(v0, v2);
-    const float dot11 = glm::dot(v1, v1);
-    const float dot12 = glm::dot(v1, v2);
-
-    // Compute barycentric coordinates
-    const float invDenom = 1.0f / (dot00 * dot11 - dot01 * dot01);
-    const float u = (dot11 * dot02 - dot01 * dot12) * invDenom;
-    const float v = (dot00 * dot12 - dot01 * dot02) * invDenom;
-
-    // if( (u >= 0) && (v >= 0) && (u + v < 1) ) {
-    if( (u + getEpsilon() >= 0.0f) && (v + getEpsilon() >= 0.0f) && (u + v <= 1.0f + getEpsilon()) ) {
-      // std::cout << "BB" << std::endl;
-      glm::vec3 edge1 = verticies_[i+1] - verticies_[i];
-      glm::vec3 edge2 = verticies_[i+2] - verticies_[i]; 
-      if( hasNormals_ ) {
-        return normals_[i];
-      } else {
-        return glm::normalize(glm::cross(edge1, edge2));
+    leafBlocks_[node.offset] = triangleBlocks_.size();
+
+    for(unsigned int p=0; p<node.count; p++) {
+      if( p % TriangleBlock::width == 0 ) {
+        triangleBlocks_.push_back(TriangleBlock{});
+        triangleBlocks_.back().clear();
       }
+      const unsigned int triangle = triangles[node.offset + p];
+      const unsigned int i = 3 * triangle;
+      triangleBlocks_.back().set(p % TriangleBlock::width, triangle, verticies_[i], verticies_[i+1], verticies_[i+2]);
     }
   }
-
-  // std::cout << "EH" << std::endl;
-  return glm::vec3(0.0f, 1.0f, 0.0f);
 }
 
 
-bool TriangleMesh::triangleIntersection(const Ray* ray, 
-                                        const glm::vec3& v1, 
-                                        const glm::vec3& v2, 
-                                        const glm::vec3& v3, 
-                                        glm::vec3& intersection,
-                                        glm::vec3& normal,
-                                        float& t) const {
+std::pair<Mesh::Intersection, HitRecord> TriangleMesh::getIntersections(const Ray* ray) const {
 
-  // Find vectors for two edges sharing v1
-  const glm::vec3 e1 = v2 - v1;
-  const glm::vec3 e2 = v3 - v1;
+  float nearestT = std::numeric_limits<float>::max();
+  unsigned int nearestTriangle = 0;
+  glm::vec2 nearestBarycentrics;
+
+  const glm::vec3 origin = ray->getOrigin();
+  const glm::vec3 direction = ray->getDirection();
+
+  const bool hit = bvh_.intersectLeaves(ray, nearestT, [&](const unsigned int first, const unsigned int count, float& tMax) {
+    return intersectLeaf(first, count, false, [&](const TriangleBlock& block, const unsigned int laneMask) {
+      unsigned int lane;
+      if( intersectTriangleBlock(block, laneMask, origin, direction, tMax, lane, nearestBarycentrics) ) {
+        nearestTriangle = block.triangles[lane];
+        return true;
+      }
+      return false;
+    });
+  });
 
-  const glm::vec3 D = ray->getDirection();
+  if( !hit ) {
+    return std::make_pair(Mesh::Intersection::MISS, HitRecord{});
+  }
 
-  // // Backface culling
-  normal = glm::normalize(glm::cross(e1, e2));
-  // if( glm::dot(N, -D) <= getEpsilon() ) {
-  //   return false;
-  // }
+  return std::make_pair(Mesh::Intersection::SINGLE_HIT, getHitRecord(ray, nearestT, nearestTriangle, nearestBarycentrics));
 
-  // Begin calculating determinant - also used to calculate u parameter
-  const glm::vec3 P = glm::cross(D, e2);
+}
 
-  // If determinant is near zero, ray lies in plane of triangle
-  const float det = glm::dot(e1, P);
 
-  // NOT CULLING
-  if( det > -EPSILON && det < EPSILON ) {
-    return false;
+unsigned long long TriangleMesh::getPacketIntersections(const RayPacket& packet, const unsigned long long rayMask, HitRecord* hits) const {
+  if( !packet.isCoherent() ) {
+    return Mesh::getPacketIntersections(packet, rayMask, hits);
   }
 
-  const glm::vec3 O = ray->getOrigin();
+  float nearestT[RayPacket::maxSize];
+  unsigned int nearestTriangle[RayPacket::maxSize];
+  glm::vec2 nearestBarycentrics[RayPacket::maxSize];
+
+  std::fill(nearestT, nearestT + packet.getSize(), std::numeric_limits<float>::max());
+
+  const unsigned long long hitMask = bvh_.intersectPacketLeaves(packet, rayMask, nearestT, [&](const unsigned int first, const unsigned int count, const unsigned long long leafRayMask, float* tMax) {
+    unsigned long long closer = 0;
 
-  // Calculate distance from v1 to ray origin
-  const glm::vec3 T = O - v1;
+    for(unsigned int r=0; r<packet.getSize(); r++) {
+      if( !(leafRayMask & (1ull << r)) ) {
+        continue;
+      }
 
-  const float inv_det = 1.0f / det;
+      const Ray* ray = packet.getRay(r);
+      const glm::vec3 origin = ray->getOrigin();
+      const glm::vec3 direction = ray->getDirection();
+
+      const bool hit = intersectLeaf(first, count, false, [&](const TriangleBlock& block, const unsigned int laneMask) {
+        unsigned int lane;
+        if( intersectTriangleBlock(block, laneMask, origin, direction, tMax[r], lane, nearestBarycentrics[r]) ) {
+          nearestTriangle[r] = block.triangles[lane];
+          return true;
+        }
+        return false;
+      });
+
+      if( hit ) {
+        closer |= 1ull << r;
+      }
+    }
 
-  // Calculate u parameter and test bound
-  const float u = glm::dot(T, P) * inv_det;
+    return closer;
+  });
 
-  // The intersection lies outside of the triangle
-  if( u < 0.0f || u > 1.0f ) {
-    return false;
+  for(unsigned int i=0; i<packet.getSize(); i++) {
+    if( hitMask & (1ull << i) ) {
+      hits[i] = getHitRecord(packet.getRay(i), nearestT[i], nearestTriangle[i], nearestBarycentrics[i]);
+    }
   }
 
-  // Prepare to test v parameter
-  const glm::vec3 Q = glm::cross(T, e1);
+  return hitMask;
+}
+
+
+HitRecord TriangleMesh::getHitRecord(const Ray* ray, const float t, const unsigned int triangle, const glm::vec2& barycentrics) const {
+  const unsigned int i = 3 * triangle;
+  const float u = barycentrics.x;
+  const float v = barycentrics.y;
 
-  // Calculate V parameter and test bound
-  const float v = glm::dot(D, Q) * inv_det;
+  HitRecord hitRecord;
+  hitRecord.t = t;
+  hitRecord.primitive = triangle;
+  hitRecord.barycentrics = barycentrics;
+  hitRecord.position = ray->getOrigin() + t * ray->getDirection();
+  hitRecord.normal = glm::normalize(glm::cross(verticies_[i+1] - verticies_[i], verticies_[i+2] - verticies_[i]));
 
-  // The intersection lies outside of the triangle
-  if( v < 0.0f || u + v  > 1.0f ) {
-    return false;
+  if( hasNormals_ ) {
+    hitRecord.shadingNormal = glm::normalize((1.0f - u - v) * normals_[i] + u * normals_[i+1] + v * normals_[i+2]);
+  } else {
+    hitRecord.shadingNormal = hitRecord.normal;
   }
 
-  t = glm::dot(e2, Q) * inv_det;
+  return hitRecord;
+}
 
-  if( t > EPSILON ) { //ray intersection
-    intersection = O + t * D;
-    return true;
-  }
 
-  return false;
+bool TriangleMesh::occludes(const Ray* ray, const float tMax) const {
+  const glm::vec3 origin = ray->getOrigin();
+  const glm::vec3 direction = ray->getDirection();
+
+  return bvh_.occludedLeaves(ray, tMax, [&](const unsigned int first, const unsigned int count) {
+    return intersectLeaf(first, count, true, [&](const TriangleBlock& block, const unsigned int laneMask) {
+      float t = tMax;
+      unsigned int lane;
+      glm::vec2 barycentrics;
+      return intersectTriangleBlock(block, laneMask, origin, direction, t, lane, barycentrics);
+    });
+  });
 }
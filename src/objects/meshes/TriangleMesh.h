@@ -5,41 +5,102 @@
 #include <vector>
 #include <algorithm>
 #include <limits>
+#include <stdexcept>
 
 #include "glm/glm.hpp"
 
 #include "Mesh.h"
 
-#include "utils/random.h"
+#include "acceleration/BoundingBox.h"
+#include "acceleration/Bvh.h"
+#include "acceleration/TriangleBlock.h"
 
-#define EPSILON 0.000001
+#include "utils/random.h"
 
 
 class TriangleMesh : public Mesh {
 
 public:
-  TriangleMesh(const std::vector<glm::vec3> verticies, const std::vector<glm::vec3> normals = std::vector<glm::vec3>{});
+  // The BVH is built on threadPool when one is given
+  TriangleMesh(const std::vector<glm::vec3> verticies, 
+               const std::vector<glm::vec3> normals = std::vector<glm::vec3>{}, 
+               ThreadPool* threadPool = nullptr);
 
   virtual ~TriangleMesh() = default;
 
-  std::tuple<Mesh::Intersection, float, float> getIntersections(const Ray* ray) const override;
+  std::pair<Mesh::Intersection, HitRecord> getIntersections(const Ray* ray) const override;
+
+  unsigned long long getPacketIntersections(const RayPacket& packet, const unsigned long long rayMask, HitRecord* hits) const override;
+
+  bool occludes(const Ray* ray, const float tMax) const override;
+
+  BoundingBox getBounds() const override { return bvh_.getBounds(); }
+
+  // Places the mesh with transform relative to the verticies it was created with 
+  // and refits its BVH
+  void setTransform(const glm::mat4& transform) override;
 
-  glm::vec3 getNormal(const glm::vec3& position) const override;
+  // Replaces the untransformed verticies of a deforming mesh, the number of verticies 
+  // must stay the same. Without normals, or for a mesh created without them, the 
+  // current normals are kept.
+  void setVerticies(const std::vector<glm::vec3>& verticies, const std::vector<glm::vec3>& normals = std::vector<glm::vec3>{});
 
 protected:
 
 private:
-  inline float sign(const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3) const {
-    return (p1.x - p3.x) * (p2.y - p3.y) - (p2.x - p3.x) * (p1.y - p3.y);
-  }
-
-  const std::vector<glm::vec3> verticies_;
-  const std::vector<glm::vec3> normals_;
+  std::vector<glm::vec3> verticies_;
+  std::vector<glm::vec3> normals_;
   const bool hasNormals_;
 
-  bool triangleIntersection(const Ray* ray, const glm::vec3& v1, const glm::vec3& v2, const glm::vec3& v3, glm::vec3& intersection, glm::vec3& normal, float& t) const;
+  // Only kept once the mesh has been moved or deformed
+  std::vector<glm::vec3> objectVerticies_;
+  std::vector<glm::vec3> objectNormals_;
+  glm::mat4 transform_;
+
+  ThreadPool* threadPool_;
+
+  Bvh bvh_;
+
+  // The triangles of each leaf of bvh_ in primitive order, every leaf starts a new block
+  std::vector<TriangleBlock> triangleBlocks_;
+
+  // First block of the leaf whose first primitive is at each position of the primitive order
+  std::vector<unsigned int> leafBlocks_;
+
+  std::vector<BoundingBox> computeTriangleBounds() const;
+
+  void buildTriangleBlocks();
+
+  void update();
+
+  HitRecord getHitRecord(const Ray* ray, const float t, const unsigned int triangle, const glm::vec2& barycentrics) const;
+
+  // Calls intersector(block, laneMask) for the blocks covering the 
+  // primitives [first, first+count), stops at the first hit if anyHit is set
+  template<typename BlockIntersector>
+  bool intersectLeaf(const unsigned int first, const unsigned int count, const bool anyHit, BlockIntersector intersector) const;
 
 };
 
 
+template<typename BlockIntersector>
+bool TriangleMesh::intersectLeaf(const unsigned int first, const unsigned int count, const bool anyHit, BlockIntersector intersector) const {
+  bool hit = false;
+  const unsigned int firstBlock = leafBlocks_[first];
+
+  for(unsigned int i=0; i<count; i+=TriangleBlock::width) {
+    const unsigned int laneMask = (1u << std::min(count - i, TriangleBlock::width)) - 1;
+
+    if( intersector(triangleBlocks_[firstBlock + i / TriangleBlock::width], laneMask) ) {
+      if( anyHit ) {
+        return true;
+      }
+      hit = true;
+    }
+  }
+
+  return hit;
+}
+
+
 #endif // TRIANGLEMESH_H
\ No newline at end of file
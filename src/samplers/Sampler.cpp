@@ -0,0 +1,90 @@
+#include "Sampler.h"
+
+Sampler::Sampler(const unsigned int seed, const unsigned int samplesPerPixel)
+: seed_{seed}
+, samplesPerPixel_{samplesPerPixel} {
+
+}
+
+Sampler::~Sampler() {
+
+}
+
+void Sampler::fill1D(const unsigned int pixel, 
+                     const unsigned int sample, 
+                     const unsigned int firstDimension, 
+                     const unsigned int count, 
+                     float* values) const {
+  for(unsigned int i=0; i<count; i++) {
+    values[i] = get1D(pixel, sample, firstDimension + i);
+  }
+}
+
+void Sampler::philox(unsigned int counter[4], const unsigned int key[2]) {
+  unsigned int key0 = key[0];
+  unsigned int key1 = key[1];
+
+  for(unsigned int round=0; round<10; round++) {
+    const unsigned long long product0 = 0xD2511F53ULL * counter[0];
+    const unsigned long long product1 = 0xCD9E8D57ULL * counter[2];
+
+    const unsigned int c0 = static_cast<unsigned int>(product1 >> 32) ^ counter[1] ^ key0;
+    const unsigned int c1 = static_cast<unsigned int>(product1);
+    const unsigned int c2 = static_cast<unsigned int>(product0 >> 32) ^ counter[3] ^ key1;
+    const unsigned int c3 = static_cast<unsigned int>(product0);
+
+    counter[0] = c0;
+    counter[1] = c1;
+    counter[2] = c2;
+    counter[3] = c3;
+
+    key0 += 0x9E3779B9u;
+    key1 += 0xBB67AE85u;
+  }
+}
+
+void Sampler::getRandomBits(const unsigned int pixel,
+                            const unsigned int sample,
+                            const unsigned int dimension,
+                            const unsigned int stream,
+                            unsigned int bits[4]) const {
+  bits[0] = dimension;
+  bits[1] = sample;
+  bits[2] = pixel;
+  bits[3] = stream;
+  const unsigned int key[2] = {seed_, 0};
+  philox(bits, key);
+}
+
+unsigned int Sampler::permute(unsigned int index, const unsigned int length, const unsigned int seed) {
+  unsigned int mask = length - 1;
+  mask |= mask >> 1;
+  mask |= mask >> 2;
+  mask |= mask >> 4;
+  mask |= mask >> 8;
+  mask |= mask >> 16;
+
+  // Permutes within the next power of two and walks the cycle until it is back in range
+  do {
+    index ^= seed;
+    index *= 0xe170893d;
+    index ^= seed >> 16;
+    index ^= (index & mask) >> 4;
+    index ^= seed >> 8;
+    index *= 0x0929eb3f;
+    index ^= seed >> 23;
+    index ^= (index & mask) >> 1;
+    index *= 1 | seed >> 27;
+    index *= 0x6935fa69;
+    index ^= (index & mask) >> 11;
+    index *= 0x74dcb303;
+    index ^= (index & mask) >> 2;
+    index *= 0x9e501cc3;
+    index ^= (index & mask) >> 2;
+    index *= 0xc860a3df;
+    index &= mask;
+    index ^= index >> 5;
+  } while( index >= length );
+
+  return (index + seed) % length;
+}
@@ -0,0 +1,72 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <algorithm>
+
+#include "glm/glm.hpp"
+
+
+// Source of the random numbers of the camera paths. Dimension d of sample s of a pixel
+// is a pure function of (seed, pixel, s, d), whichever thread or process asks for it.
+// A dimension is one request, of one or two values, and the integrator keeps the
+// requests of a bounce at the same dimensions in every sample. The samplers spread the
+// samples of a pixel evenly over each dimension, and randomize that per pixel and
+// dimension so that every single sample stays uniformly distributed.
+class Sampler {
+public:
+  Sampler(const unsigned int seed, const unsigned int samplesPerPixel);
+  virtual ~Sampler();
+
+  // Uniform in [0, 1)
+  virtual float get1D(const unsigned int pixel, const unsigned int sample, const unsigned int dimension) const = 0;
+
+  // Uniform in [0, 1)^2
+  virtual glm::vec2 get2D(const unsigned int pixel, const unsigned int sample, const unsigned int dimension) const = 0;
+
+  // get1D() of count dimensions from firstDimension on, into values. The default asks 
+  // for one after the other, samplers that can do better draw them in a batch.
+  virtual void fill1D(const unsigned int pixel, 
+                      const unsigned int sample, 
+                      const unsigned int firstDimension, 
+                      const unsigned int count, 
+                      float* values) const;
+
+  unsigned int getSamplesPerPixel() const { return samplesPerPixel_; }
+
+  // Philox4x32-10 of Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3".
+  // Turns counter into four random words under key.
+  static void philox(unsigned int counter[4], const unsigned int key[2]);
+
+protected:
+  const unsigned int seed_;
+  const unsigned int samplesPerPixel_;
+
+  // Four random words for the request, stream tells apart the uses within one request.
+  // Sample 0 of stream 1 and above serves as the seed of the whole pixel and dimension.
+  void getRandomBits(const unsigned int pixel,
+                     const unsigned int sample,
+                     const unsigned int dimension,
+                     const unsigned int stream,
+                     unsigned int bits[4]) const;
+
+  // Kensler's hashed permutation of [0, length), "Correlated Multi-Jittered Sampling"
+  static unsigned int permute(unsigned int index, const unsigned int length, const unsigned int seed);
+
+  static unsigned int reverseBits(unsigned int bits) {
+    bits = (bits << 16) | (bits >> 16);
+    bits = ((bits & 0x00ff00ffu) << 8) | ((bits & 0xff00ff00u) >> 8);
+    bits = ((bits & 0x0f0f0f0fu) << 4) | ((bits & 0xf0f0f0f0u) >> 4);
+    bits = ((bits & 0x33333333u) << 2) | ((bits & 0xccccccccu) >> 2);
+    return ((bits & 0x55555555u) << 1) | ((bits & 0xaaaaaaaau) >> 1);
+  }
+
+  static float toFloat(const unsigned int bits) { return (bits >> 8) * (1.0f / 16777216.0f); }
+
+  // Keeps a value that rounded up to 1 in [0, 1)
+  static float belowOne(const float value) { return std::min(value, 0.99999994f); }
+
+private:
+
+};
+
+#endif
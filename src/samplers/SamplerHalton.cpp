@@ -0,0 +1,61 @@
+#include "SamplerHalton.h"
+
+const unsigned int SamplerHalton::numberOfBases_;
+
+SamplerHalton::SamplerHalton(const unsigned int seed, const unsigned int samplesPerPixel)
+: Sampler(seed, samplesPerPixel) {
+  bases_.reserve(numberOfBases_);
+  for(unsigned int candidate=2; bases_.size()<numberOfBases_; candidate++) {
+    bool prime = true;
+    for(unsigned int i=0; i<bases_.size() && bases_[i] * bases_[i] <= candidate; i++) {
+      if( candidate % bases_[i] == 0 ) {
+        prime = false;
+        break;
+      }
+    }
+    if( prime ) {
+      bases_.push_back(candidate);
+    }
+  }
+}
+
+SamplerHalton::~SamplerHalton() {
+
+}
+
+float SamplerHalton::get1D(const unsigned int pixel, const unsigned int sample, const unsigned int dimension) const {
+  unsigned int seeds[4];
+  getRandomBits(pixel, 0, dimension, 1, seeds);
+
+  const unsigned int base = (2 * dimension) % numberOfBases_;
+  return scrambledRadicalInverse(bases_[base], sample, seeds[0]);
+}
+
+glm::vec2 SamplerHalton::get2D(const unsigned int pixel, const unsigned int sample, const unsigned int dimension) const {
+  unsigned int seeds[4];
+  getRandomBits(pixel, 0, dimension, 1, seeds);
+
+  const unsigned int base = (2 * dimension) % numberOfBases_;
+  return glm::vec2{scrambledRadicalInverse(bases_[base], sample, seeds[0]), 
+                   scrambledRadicalInverse(bases_[base + 1], sample, seeds[1])};
+}
+
+float SamplerHalton::scrambledRadicalInverse(const unsigned int base, unsigned int index, const unsigned int seed) const {
+  // Samples past the first samplesPerPixel points take all the digits they have
+  unsigned int digits = std::max(index, samplesPerPixel_ - 1);
+
+  double inverse = 0.0;
+  double digitWeight = 1.0 / base;
+  unsigned int digitSeed = seed;
+  while( digits > 0 ) {
+    inverse += permute(index % base, base, digitSeed) * digitWeight;
+    index /= base;
+    digits /= base;
+    digitWeight /= base;
+    digitSeed = digitSeed * 0x9E3779B9u + 1;
+  }
+
+  // The permuted zero digits that follow
+  inverse += toFloat(digitSeed) * digitWeight;
+  return belowOne(static_cast<float>(inverse));
+}
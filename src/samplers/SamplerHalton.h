@@ -0,0 +1,37 @@
+#ifndef SAMPLER_HALTON_H
+#define SAMPLER_HALTON_H
+
+#include <vector>
+
+#include "Sampler.h"
+
+// The Halton sequence, with a prime base of its own for every value: dimension d takes
+// the primes 2d and 2d + 1 in order, get1D() the first of them. Dimensions past the
+// table of bases start over at its beginning. The large bases of the high dimensions
+// would be correlated and, for few samples, crowd into the bottom of [0, 1), so every
+// digit goes through a random permutation of its own per pixel and dimension (Faure and
+// Lemieux, "Generalized Halton Sequences in 2008"). Sample s of a pixel is point s.
+class SamplerHalton : public Sampler {
+public:
+  SamplerHalton(const unsigned int seed, const unsigned int samplesPerPixel);
+  virtual ~SamplerHalton();
+
+  virtual float get1D(const unsigned int pixel, const unsigned int sample, const unsigned int dimension) const override;
+
+  virtual glm::vec2 get2D(const unsigned int pixel, const unsigned int sample, const unsigned int dimension) const override;
+
+protected:
+
+private:
+  static const unsigned int numberOfBases_ = 512;
+
+  std::vector<unsigned int> bases_;
+
+  // Radical inverse of index in base with the digits permuted by seed. Takes as many 
+  // digits as the last sample of a pixel has and a random offset below the last of 
+  // them for the rest, so every point of a pixel lands in a stratum of its own.
+  float scrambledRadicalInverse(const unsigned int base, unsigned int index, const unsigned int seed) const;
+
+};
+
+#endif
@@ -0,0 +1,111 @@
+#include "SamplerIndependent.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SAMPLER_INDEPENDENT_SIMD
+#include <immintrin.h>
+#endif
+
+// Dimensions per batch of the SIMD kernel
+static const unsigned int lanes = 8;
+
+SamplerIndependent::SamplerIndependent(const unsigned int seed, const unsigned int samplesPerPixel)
+: Sampler(seed, samplesPerPixel) {
+
+}
+
+SamplerIndependent::~SamplerIndependent() {
+
+}
+
+float SamplerIndependent::get1D(const unsigned int pixel, const unsigned int sample, const unsigned int dimension) const {
+  unsigned int bits[4];
+  getRandomBits(pixel, sample, dimension, 0, bits);
+  return toFloat(bits[0]);
+}
+
+glm::vec2 SamplerIndependent::get2D(const unsigned int pixel, const unsigned int sample, const unsigned int dimension) const {
+  unsigned int bits[4];
+  getRandomBits(pixel, sample, dimension, 0, bits);
+  return glm::vec2{toFloat(bits[0]), toFloat(bits[1])};
+}
+
+
+#ifdef SAMPLER_INDEPENDENT_SIMD
+
+// High and low 32 bits of the products of the eight lanes of a with multiplier
+__attribute__((target("avx2")))
+static inline void multiplyWide(const __m256i a, const __m256i multiplier, __m256i& high, __m256i& low) {
+  const __m256i even = _mm256_mul_epu32(a, multiplier);
+  const __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), multiplier);
+  high = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xaa);
+  low = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xaa);
+}
+
+
+// Sampler::philox() of the counters (firstDimension + lane, sample, pixel, 0), 
+// the first word of each as get1D() turns it into a value
+__attribute__((target("avx2")))
+static void fillLanesAvx(const unsigned int seed,
+                         const unsigned int pixel,
+                         const unsigned int sample,
+                         const unsigned int firstDimension,
+                         float* values,
+                         const unsigned int blocks) {
+  const __m256i multiplier0 = _mm256_set1_epi32(static_cast<int>(0xD2511F53u));
+  const __m256i multiplier1 = _mm256_set1_epi32(static_cast<int>(0xCD9E8D57u));
+  const __m256 scale = _mm256_set1_ps(1.0f / 16777216.0f);
+
+  for(unsigned int block=0; block<blocks; block++) {
+    __m256i c0 = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(firstDimension + block * lanes)), 
+                                  _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    __m256i c1 = _mm256_set1_epi32(static_cast<int>(sample));
+    __m256i c2 = _mm256_set1_epi32(static_cast<int>(pixel));
+    __m256i c3 = _mm256_setzero_si256();
+    unsigned int key0 = seed;
+    unsigned int key1 = 0;
+
+    for(unsigned int round=0; round<10; round++) {
+      __m256i high0, low0, high1, low1;
+      multiplyWide(c0, multiplier0, high0, low0);
+      multiplyWide(c2, multiplier1, high1, low1);
+
+      c0 = _mm256_xor_si256(_mm256_xor_si256(high1, c1), _mm256_set1_epi32(static_cast<int>(key0)));
+      c1 = low1;
+      c2 = _mm256_xor_si256(_mm256_xor_si256(high0, c3), _mm256_set1_epi32(static_cast<int>(key1)));
+      c3 = low0;
+
+      key0 += 0x9E3779B9u;
+      key1 += 0xBB67AE85u;
+    }
+
+    _mm256_storeu_ps(values + block * lanes, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(c0, 8)), scale));
+  }
+}
+
+
+static bool supportsAvx2() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+
+#endif
+
+
+void SamplerIndependent::fill1D(const unsigned int pixel, 
+                                const unsigned int sample, 
+                                const unsigned int firstDimension, 
+                                const unsigned int count, 
+                                float* values) const {
+  unsigned int filled = 0;
+
+#ifdef SAMPLER_INDEPENDENT_SIMD
+  static const bool avx2 = supportsAvx2();
+  if( avx2 ) {
+    const unsigned int blocks = count / lanes;
+    fillLanesAvx(seed_, pixel, sample, firstDimension, values, blocks);
+    filled = blocks * lanes;
+  }
+#endif
+
+  Sampler::fill1D(pixel, sample, firstDimension + filled, count - filled, values + filled);
+}
@@ -0,0 +1,29 @@
+#ifndef SAMPLER_INDEPENDENT_H
+#define SAMPLER_INDEPENDENT_H
+
+#include "Sampler.h"
+
+// Independent uniform values, no two samples know of each other
+class SamplerIndependent : public Sampler {
+public:
+  SamplerIndependent(const unsigned int seed, const unsigned int samplesPerPixel);
+  virtual ~SamplerIndependent();
+
+  virtual float get1D(const unsigned int pixel, const unsigned int sample, const unsigned int dimension) const override;
+
+  virtual glm::vec2 get2D(const unsigned int pixel, const unsigned int sample, const unsigned int dimension) const override;
+
+  // Eight dimensions at a time with AVX2 when the CPU supports it
+  virtual void fill1D(const unsigned int pixel, 
+                      const unsigned int sample, 
+                      const unsigned int firstDimension, 
+                      const unsigned int count, 
+                      float* values) const override;
+
+protected:
+
+private:
+
+};
+
+#endif
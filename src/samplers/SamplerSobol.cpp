@@ -0,0 +1,76 @@
+#include "SamplerSobol.h"
+
+
+// Second dimension of the Sobol sequence for every value of every byte of the index
+struct Sobol1Table {
+  unsigned int bytes[4][256];
+
+  Sobol1Table() {
+    // Direction numbers of the primitive polynomial x + 1, each is the one before 
+    // xor itself shifted by one
+    unsigned int directions[32];
+    directions[0] = 0x80000000u;
+    for(unsigned int bit=1; bit<32; bit++) {
+      directions[bit] = directions[bit - 1] ^ (directions[bit - 1] >> 1);
+    }
+
+    for(unsigned int byte=0; byte<4; byte++) {
+      for(unsigned int value=0; value<256; value++) {
+        bytes[byte][value] = 0;
+        for(unsigned int bit=0; bit<8; bit++) {
+          if( value & (1u << bit) ) {
+            bytes[byte][value] ^= directions[byte * 8 + bit];
+          }
+        }
+      }
+    }
+  }
+};
+
+static const Sobol1Table sobol1Table;
+
+
+SamplerSobol::SamplerSobol(const unsigned int seed, const unsigned int samplesPerPixel)
+: Sampler(seed, samplesPerPixel) {
+
+}
+
+SamplerSobol::~SamplerSobol() {
+
+}
+
+float SamplerSobol::get1D(const unsigned int pixel, const unsigned int sample, const unsigned int dimension) const {
+  unsigned int seeds[4];
+  getRandomBits(pixel, 0, dimension, 1, seeds);
+
+  const unsigned int index = nestedUniformScramble(sample, seeds[0]);
+  return toFloat(nestedUniformScramble(reverseBits(index), seeds[1]));
+}
+
+glm::vec2 SamplerSobol::get2D(const unsigned int pixel, const unsigned int sample, const unsigned int dimension) const {
+  unsigned int seeds[4];
+  getRandomBits(pixel, 0, dimension, 1, seeds);
+
+  const unsigned int index = nestedUniformScramble(sample, seeds[0]);
+  return glm::vec2{toFloat(nestedUniformScramble(reverseBits(index), seeds[1])),
+                   toFloat(nestedUniformScramble(sobol1(index), seeds[2]))};
+}
+
+unsigned int SamplerSobol::sobol1(const unsigned int index) {
+  // The sequence is linear in the bits of the index, so each byte is looked up on its own
+  return sobol1Table.bytes[0][index & 0xff] ^ sobol1Table.bytes[1][(index >> 8) & 0xff] ^
+         sobol1Table.bytes[2][(index >> 16) & 0xff] ^ sobol1Table.bytes[3][index >> 24];
+}
+
+unsigned int SamplerSobol::laineKarrasPermutation(unsigned int bits, const unsigned int seed) {
+  bits += seed;
+  bits ^= bits * 0x6c50b47cu;
+  bits ^= bits * 0xb82f1e52u;
+  bits ^= bits * 0xc7afe638u;
+  bits ^= bits * 0x8d22f6e6u;
+  return bits;
+}
+
+unsigned int SamplerSobol::nestedUniformScramble(const unsigned int bits, const unsigned int seed) {
+  return reverseBits(laineKarrasPermutation(reverseBits(bits), seed));
+}
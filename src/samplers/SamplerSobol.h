@@ -0,0 +1,32 @@
+#ifndef SAMPLER_SOBOL_H
+#define SAMPLER_SOBOL_H
+
+#include "Sampler.h"
+
+// The first two dimensions of the Sobol sequence, Owen scrambled with the hash based
+// scheme of Burley, "Practical Hash-based Owen Scrambling". Every dimension shuffles the
+// sample indices and scrambles the point with seeds of its own per pixel, which pads
+// the two dimensions to any number of them. The samples of a pixel stay a (0, m, 2)-net
+// for every power of two samplesPerPixel.
+class SamplerSobol : public Sampler {
+public:
+  SamplerSobol(const unsigned int seed, const unsigned int samplesPerPixel);
+  virtual ~SamplerSobol();
+
+  virtual float get1D(const unsigned int pixel, const unsigned int sample, const unsigned int dimension) const override;
+
+  virtual glm::vec2 get2D(const unsigned int pixel, const unsigned int sample, const unsigned int dimension) const override;
+
+protected:
+
+private:
+  // Second dimension of the Sobol sequence, the first is the bit reversed index
+  static unsigned int sobol1(const unsigned int index);
+
+  static unsigned int laineKarrasPermutation(unsigned int bits, const unsigned int seed);
+
+  static unsigned int nestedUniformScramble(const unsigned int bits, const unsigned int seed);
+
+};
+
+#endif
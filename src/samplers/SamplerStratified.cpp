@@ -0,0 +1,60 @@
+#include "SamplerStratified.h"
+
+SamplerStratified::SamplerStratified(const unsigned int seed, const unsigned int samplesPerPixel)
+: Sampler(seed, samplesPerPixel)
+, gridSize_{0} {
+  const unsigned int root = static_cast<unsigned int>(std::lround(std::sqrt(static_cast<double>(samplesPerPixel))));
+  if( root * root == samplesPerPixel ) {
+    gridSize_ = root;
+  }
+}
+
+SamplerStratified::~SamplerStratified() {
+
+}
+
+float SamplerStratified::get1D(const unsigned int pixel, const unsigned int sample, const unsigned int dimension) const {
+  unsigned int jitter[4];
+  getRandomBits(pixel, sample, dimension, 0, jitter);
+
+  // Samples past the strata have none left and are independent
+  if( sample >= samplesPerPixel_ ) {
+    return toFloat(jitter[0]);
+  }
+
+  unsigned int seeds[4];
+  getRandomBits(pixel, 0, dimension, 1, seeds);
+
+  const unsigned int stratum = permute(sample, samplesPerPixel_, seeds[0]);
+  return belowOne((stratum + toFloat(jitter[0])) / samplesPerPixel_);
+}
+
+glm::vec2 SamplerStratified::get2D(const unsigned int pixel, const unsigned int sample, const unsigned int dimension) const {
+  unsigned int jitter[4];
+  getRandomBits(pixel, sample, dimension, 0, jitter);
+
+  if( sample >= samplesPerPixel_ ) {
+    return glm::vec2{toFloat(jitter[0]), toFloat(jitter[1])};
+  }
+
+  unsigned int seeds[4];
+  getRandomBits(pixel, 0, dimension, 1, seeds);
+
+  unsigned int x;
+  unsigned int y;
+  unsigned int strata;
+
+  if( gridSize_ > 0 ) {
+    const unsigned int cell = permute(sample, samplesPerPixel_, seeds[0]);
+    x = cell % gridSize_;
+    y = cell / gridSize_;
+    strata = gridSize_;
+  } else {
+    x = permute(sample, samplesPerPixel_, seeds[0]);
+    y = permute(sample, samplesPerPixel_, seeds[1]);
+    strata = samplesPerPixel_;
+  }
+
+  return glm::vec2{belowOne((x + toFloat(jitter[0])) / strata),
+                   belowOne((y + toFloat(jitter[1])) / strata)};
+}
@@ -0,0 +1,29 @@
+#ifndef SAMPLER_STRATIFIED_H
+#define SAMPLER_STRATIFIED_H
+
+#include <cmath>
+
+#include "Sampler.h"
+
+// Jittered strata: every dimension is split into samplesPerPixel strata and each
+// sample of a pixel takes one of them, in an order shuffled per pixel and dimension.
+// When samplesPerPixel is a square the 2D requests use a jittered grid, otherwise
+// each of their axes is stratified on its own (a Latin hypercube).
+class SamplerStratified : public Sampler {
+public:
+  SamplerStratified(const unsigned int seed, const unsigned int samplesPerPixel);
+  virtual ~SamplerStratified();
+
+  virtual float get1D(const unsigned int pixel, const unsigned int sample, const unsigned int dimension) const override;
+
+  virtual glm::vec2 get2D(const unsigned int pixel, const unsigned int sample, const unsigned int dimension) const override;
+
+protected:
+
+private:
+  // Strata per axis of the 2D grid, 0 when samplesPerPixel is not a square
+  unsigned int gridSize_;
+
+};
+
+#endif
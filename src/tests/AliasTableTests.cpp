@@ -0,0 +1,106 @@
+#include "Tests.h"
+
+#include <vector>
+#include <cmath>
+
+#include "Scene.h"
+
+#include "objects/OpaqueObject.h"
+#include "objects/meshes/BoxMesh.h"
+#include "objects/meshes/SphereMesh.h"
+#include "objects/brdfs/BrdfLambertian.h"
+
+#include "samplers/SamplerIndependent.h"
+
+#include "utils/AliasTable.h"
+#include "utils/Pcg32.h"
+#include "utils/RandomSequence.h"
+
+
+// Fraction of [0, 1) that samples each index, measured on a grid fine enough to hit every threshold
+static std::vector<double> measureFrequencies(const AliasTable& table) {
+  const unsigned int steps = 1 << 20;
+  std::vector<double> frequencies(table.getSize(), 0.0);
+  for(unsigned int i=0; i<steps; i++) {
+    frequencies[table.sample((i + 0.5f) / steps)] += 1.0 / steps;
+  }
+  return frequencies;
+}
+
+
+// Lights that emit nothing, such as those turned off, shall never be picked
+static unsigned int testZeroWeights() {
+  Pcg32 generator{11};
+  unsigned int failures = 0;
+
+  for(unsigned int test=0; test<200; test++) {
+    const unsigned int size = 1 + generator.next() % 40;
+    std::vector<float> weights(size);
+    for(unsigned int i=0; i<size; i++) {
+      weights[i] = generator.next() % 3 == 0 ? 0.0f : generator.next0To1() * (generator.next() % 2 == 0 ? 1.0f : 1000.0f);
+    }
+    weights[generator.next() % size] = 1.0f;
+
+    const AliasTable table{weights};
+    const std::vector<double> frequencies = measureFrequencies(table);
+
+    double sum = 0.0;
+    for(const float weight : weights) {
+      sum += weight;
+    }
+
+    for(unsigned int i=0; i<size; i++) {
+      if( weights[i] == 0.0f ) {
+        failures += expect(frequencies[i] == 0.0 && table.getProbability(i) == 0.0f, 
+                           "zero weight " + std::to_string(i) + " is sampled in table " + std::to_string(test));
+
+        // Also the ends of its own entry, where rounding would show
+        const float first = static_cast<float>(i) / size;
+        const float last = std::nextafter(static_cast<float>(i + 1) / size, 0.0f);
+        failures += expect(table.sample(first) != i && table.sample(last) != i, 
+                           "zero weight " + std::to_string(i) + " is sampled at the ends of its entry in table " + std::to_string(test));
+      } else {
+        failures += expect(std::abs(frequencies[i] - weights[i] / sum) < 1e-4, 
+                           "index " + std::to_string(i) + " is sampled with the wrong probability in table " + std::to_string(test));
+      }
+    }
+  }
+
+  return failures;
+}
+
+
+// A scene whose lights include one that emits nothing, sampled by power and by the light BVH
+static unsigned int testDarkLight() {
+  unsigned int failures = 0;
+
+  for(const bool lightBvh : {false, true}) {
+    Scene scene;
+    OpaqueObject* floor = new OpaqueObject{"floor", new BoxMesh{glm::vec2{-10, 10}, glm::vec2{-10, -9}, glm::vec2{-10, 10}},
+                                           new BrdfLambertian{1.0f}};
+    scene.add(floor);
+    scene.add(new OpaqueObject{"light", new SphereMesh{glm::vec3{0.0f, 0.0f, 0.0f}, 1.0f},
+                               new BrdfLambertian{1.0f}, true, glm::vec3{1.0f, 1.0f, 1.0f}});
+    scene.add(new OpaqueObject{"darkLight", new SphereMesh{glm::vec3{3.0f, 0.0f, 0.0f}, 1.0f},
+                               new BrdfLambertian{1.0f}, true, glm::vec3{0.0f, 0.0f, 0.0f}});
+    scene.setLightBvh(lightBvh);
+    scene.complete();
+
+    const SamplerIndependent sampler{1, 1};
+    const glm::vec3 normal{0.0f, 1.0f, 0.0f};
+    bool finite = true;
+    for(unsigned int i=0; i<10000; i++) {
+      RandomSequence sequence{&sampler, i, 0};
+      const glm::vec3 light = scene.castShadowRays(glm::vec3{0.0f, -9.0f, 0.0f}, glm::vec3{0.0f, 0.0f, 1.0f}, floor, 1, normal, sequence);
+      finite = finite && std::isfinite(light.r) && std::isfinite(light.g) && std::isfinite(light.b);
+    }
+    failures += expect(finite, std::string{"shadow rays to a dark light are not finite"} + (lightBvh ? " with the light BVH" : ""));
+  }
+
+  return failures;
+}
+
+
+unsigned int testAliasTable() {
+  return testZeroWeights() + testDarkLight();
+}
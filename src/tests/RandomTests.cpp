@@ -0,0 +1,83 @@
+#include "Tests.h"
+
+#include <vector>
+#include <memory>
+#include <cstring>
+
+#include "samplers/Sampler.h"
+#include "samplers/SamplerIndependent.h"
+#include "samplers/SamplerStratified.h"
+#include "samplers/SamplerHalton.h"
+#include "samplers/SamplerSobol.h"
+
+#include "utils/Pcg32.h"
+
+
+static bool sameBits(const float a, const float b) {
+  return std::memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+
+// fill() gives the values of next0To1() and leaves the generator where they would, whether
+// the count is a whole number of SIMD blocks or not. advance() skips the same values.
+static unsigned int testGenerator() {
+  unsigned int failures = 0;
+
+  for(const unsigned int count : {0u, 1u, 7u, 8u, 9u, 64u, 1001u}) {
+    Pcg32 reference{42, count};
+    Pcg32 batch{42, count};
+
+    std::vector<float> values(count);
+    batch.fill(values.data(), count);
+
+    bool same = true;
+    for(unsigned int i=0; i<count; i++) {
+      const float value = reference.next0To1();
+      same = same && sameBits(values[i], value);
+    }
+    failures += expect(same, "fill() of " + std::to_string(count) + " values differs from next0To1()");
+    failures += expect(batch.next() == reference.next(), "fill() of " + std::to_string(count) + " values leaves the generator elsewhere");
+
+    Pcg32 skipped{42, count};
+    skipped.advance(count + 1);
+    failures += expect(skipped.next() == reference.next(), "advance(" + std::to_string(count + 1) + ") skips a different number of values");
+  }
+
+  return failures;
+}
+
+
+// fill1D() of every sampler gives the values of get1D(), from any first dimension on
+static unsigned int testSamplers() {
+  const unsigned int samplesPerPixel = 16;
+  std::vector<std::pair<std::string, std::unique_ptr<Sampler>>> samplers;
+  samplers.emplace_back("independent", std::unique_ptr<Sampler>{new SamplerIndependent{3, samplesPerPixel}});
+  samplers.emplace_back("stratified", std::unique_ptr<Sampler>{new SamplerStratified{3, samplesPerPixel}});
+  samplers.emplace_back("halton", std::unique_ptr<Sampler>{new SamplerHalton{3, samplesPerPixel}});
+  samplers.emplace_back("sobol", std::unique_ptr<Sampler>{new SamplerSobol{3, samplesPerPixel}});
+
+  unsigned int failures = 0;
+
+  for(const auto& sampler : samplers) {
+    bool same = true;
+    for(unsigned int pixel=0; pixel<50; pixel++) {
+      const unsigned int sample = pixel % (samplesPerPixel + 4);
+      const unsigned int firstDimension = (pixel * 7) % 13;
+      const unsigned int count = pixel % 27;
+
+      float values[32];
+      sampler.second->fill1D(pixel, sample, firstDimension, count, values);
+      for(unsigned int i=0; i<count; i++) {
+        same = same && sameBits(values[i], sampler.second->get1D(pixel, sample, firstDimension + i));
+      }
+    }
+    failures += expect(same, "fill1D() of the " + sampler.first + " sampler differs from get1D()");
+  }
+
+  return failures;
+}
+
+
+unsigned int testRandom() {
+  return testGenerator() + testSamplers();
+}
@@ -0,0 +1,23 @@
+#include "Tests.h"
+
+#include <vector>
+#include <utility>
+
+
+int runTests() {
+  const std::vector<std::pair<std::string, unsigned int (*)()> > tests{
+    {"triangle blocks", testTriangleBlocks},
+    {"alias table", testAliasTable},
+    {"random", testRandom}
+  };
+
+  unsigned int failures = 0;
+  for(const auto& test : tests) {
+    std::cout << test.first << std::endl;
+    const unsigned int testFailures = test.second();
+    std::cout << "  " << (testFailures == 0 ? "passed" : std::to_string(testFailures) + " checks failed") << std::endl;
+    failures += testFailures;
+  }
+
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,35 @@
+#ifndef TESTS_H
+#define TESTS_H
+
+#include <iostream>
+#include <string>
+
+
+// Self tests run with ./main --test. Every test returns its number of failed checks, 
+// runTests() runs them all and returns a non-zero exit status if any check failed.
+int runTests();
+
+// The SIMD triangle kernel gives the same hits as the scalar reference, and meshes 
+// traversing their BVH find the same nearest hits as intersecting every triangle
+unsigned int testTriangleBlocks();
+
+// Alias tables sample in proportion to the weights and never pick an index without 
+// weight, and lights that emit nothing do not break the sampling of shadow rays
+unsigned int testAliasTable();
+
+// The batches of random values, of the generator with SIMD and of the samplers, 
+// give the same values as drawing them one at a time
+unsigned int testRandom();
+
+
+// Counts and reports a failed check
+inline unsigned int expect(const bool condition, const std::string& description) {
+  if( !condition ) {
+    std::cout << "  failed: " << description << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+
+#endif // TESTS_H
@@ -0,0 +1,138 @@
+#include "Tests.h"
+
+#include <vector>
+#include <limits>
+#include <cstring>
+
+#include "glm/glm.hpp"
+
+#include "Ray.h"
+
+#include "objects/meshes/TriangleMesh.h"
+
+#include "acceleration/TriangleBlock.h"
+
+#include "benchmarks/Benchmarks.h"
+
+#include "utils/Pcg32.h"
+
+
+static glm::vec3 randomPoint(Pcg32& generator) {
+  return 2.0f * glm::vec3{generator.next0To1(), generator.next0To1(), generator.next0To1()} - 1.0f;
+}
+
+
+static bool sameBits(const float a, const float b) {
+  return std::memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+
+// Blocks of random triangles with some lanes degenerate, hit by rays aimed at random points, 
+// at the verticies and at the edges where the kernels decide hits by a hair
+static unsigned int testKernels() {
+  Pcg32 generator{7};
+  unsigned int failures = 0;
+
+  for(unsigned int test=0; test<20000; test++) {
+    TriangleBlock block;
+    block.clear();
+    glm::vec3 verticies[TriangleBlock::width][3];
+
+    for(unsigned int lane=0; lane<TriangleBlock::width; lane++) {
+      for(unsigned int v=0; v<3; v++) {
+        verticies[lane][v] = randomPoint(generator);
+      }
+      if( generator.next() % 8 == 0 ) {
+        verticies[lane][2] = verticies[lane][0] + 0.5f * (verticies[lane][1] - verticies[lane][0]);
+      }
+      block.set(lane, lane, verticies[lane][0], verticies[lane][1], verticies[lane][2]);
+    }
+
+    const glm::vec3 origin = 3.0f * randomPoint(generator);
+    const glm::vec3* triangle = verticies[generator.next() % TriangleBlock::width];
+    glm::vec3 target;
+    switch( test % 3 ) {
+      case 0: target = randomPoint(generator); break;
+      case 1: target = triangle[generator.next() % 3]; break;
+      default: target = glm::mix(triangle[0], triangle[1], generator.next0To1()); break;
+    }
+    const glm::vec3 direction = glm::normalize(target - origin);
+
+    const unsigned int laneMask = generator.next() % (1u << TriangleBlock::width);
+    const float tMax = generator.next() % 4 == 0 ? 3.0f * generator.next0To1() : std::numeric_limits<float>::max();
+
+    float referenceT = tMax;
+    unsigned int referenceLane = ~0u;
+    glm::vec2 referenceBarycentrics{-1.0f, -1.0f};
+    const bool referenceHit = intersectTriangleBlockReference(block, laneMask, origin, direction, referenceT, referenceLane, referenceBarycentrics);
+
+    float t = tMax;
+    unsigned int lane = ~0u;
+    glm::vec2 barycentrics{-1.0f, -1.0f};
+    const bool hit = intersectTriangleBlock(block, laneMask, origin, direction, t, lane, barycentrics);
+
+    const bool same = hit == referenceHit && 
+                      sameBits(t, referenceT) && 
+                      (!hit || (lane == referenceLane && 
+                                sameBits(barycentrics.x, referenceBarycentrics.x) && 
+                                sameBits(barycentrics.y, referenceBarycentrics.y)));
+    failures += expect(same, "kernel and reference disagree in test " + std::to_string(test));
+  }
+
+  return failures;
+}
+
+
+// Leaves span one or more blocks, the mesh shall find the hits of intersecting every triangle
+static unsigned int testMesh() {
+  const unsigned int triangles = 5000;
+  const unsigned int numberOfRays = 2000;
+  const std::vector<glm::vec3> verticies = createTriangleSoup(triangles, 3);
+  const TriangleMesh mesh{verticies};
+
+  std::vector<TriangleBlock> blocks((triangles + TriangleBlock::width - 1) / TriangleBlock::width);
+  for(unsigned int block=0; block<blocks.size(); block++) {
+    blocks[block].clear();
+  }
+  for(unsigned int i=0; i<triangles; i++) {
+    blocks[i / TriangleBlock::width].set(i % TriangleBlock::width, i, verticies[3*i], verticies[3*i+1], verticies[3*i+2]);
+  }
+
+  std::vector<glm::vec3> origins;
+  std::vector<glm::vec3> directions;
+  createBenchmarkRays(numberOfRays, 4, origins, directions);
+
+  unsigned int failures = 0;
+
+  for(unsigned int r=0; r<numberOfRays; r++) {
+    float nearestT = std::numeric_limits<float>::max();
+    unsigned int nearestTriangle = ~0u;
+    for(const TriangleBlock& block : blocks) {
+      unsigned int lane;
+      glm::vec2 barycentrics;
+      if( intersectTriangleBlockReference(block, (1u << TriangleBlock::width) - 1, origins[r], directions[r], nearestT, lane, barycentrics) ) {
+        nearestTriangle = block.triangles[lane];
+      }
+    }
+
+    const Ray ray{origins[r], directions[r]};
+    const std::pair<Mesh::Intersection, HitRecord> hit = mesh.getIntersections(&ray);
+    const bool found = hit.first != Mesh::Intersection::MISS;
+
+    failures += expect(found == (nearestTriangle != ~0u) && 
+                       (!found || (hit.second.t == nearestT && hit.second.primitive == nearestTriangle)), 
+                       "mesh misses the nearest hit of ray " + std::to_string(r));
+
+    if( found ) {
+      failures += expect(mesh.occludes(&ray, nearestT * 1.001f) && !mesh.occludes(&ray, nearestT * 0.999f), 
+                         "occlusion disagrees with the nearest hit of ray " + std::to_string(r));
+    }
+  }
+
+  return failures;
+}
+
+
+unsigned int testTriangleBlocks() {
+  return testKernels() + testMesh();
+}
@@ -91,6 +91,17 @@ WorkItem* ThreadPool::pop() {
 }
 
 
+WorkItem* ThreadPool::pop(const unsigned int maxPriority) {
+  WorkItem* workItem = nullptr;
+  std::lock_guard<std::mutex> guardian(queueLock_);
+  if( !queue_.empty() && queue_.top()->getPriority() <= maxPriority ) {
+    workItem = queue_.top();
+    queue_.pop();
+  }
+  return workItem;
+}
+
+
 void ThreadPool::wait() {
 
   while( true ) {
@@ -115,6 +126,25 @@ void ThreadPool::wait() {
 } 
 
 
+void ThreadPool::wait(const std::atomic<unsigned int>& pending, const unsigned int maxPriority) {
+
+  while( pending.load() > 0 ) {
+
+    WorkItem* workItem = pop(maxPriority);
+
+    if( workItem != nullptr ) {
+      workItem->dig();
+      workerFinsihedJob();
+      delete workItem;
+    } else {
+      std::this_thread::yield();
+    }
+
+  }
+
+}
+
+
 void ThreadPool::workerFinsihedJob() {
   std::lock_guard<std::mutex> guardian(numberLock_);
   numberOfFinishedWorkItems_++;
@@ -27,6 +27,9 @@ public:
 
   WorkItem* pop();
 
+  // Pops only an item whose priority is at most maxPriority
+  WorkItem* pop(const unsigned int maxPriority);
+
   void clearThreads();
 
   void clearWorkItems();
@@ -37,6 +40,21 @@ public:
 
   void wait();
 
+  // Waits until pending drops to zero, running items of at most maxPriority meanwhile. 
+  // Unlike wait() it does not wait for the rest of the pool, so it can be called from 
+  // inside a work item for items that item added and that count pending down.
+  void wait(const std::atomic<unsigned int>& pending, const unsigned int maxPriority);
+
+  // Calls work(chunk, first, count) for the chunks of chunkSize items that split 
+  // [first, first + count), as work items of priority, and waits for them with the 
+  // wait() above. A single chunk runs on the calling thread.
+  template<typename Work>
+  void parallelFor(const unsigned int first, 
+                   const unsigned int count, 
+                   const unsigned int chunkSize, 
+                   Work work, 
+                   const unsigned int priority = 0);
+
   void workerFinsihedJob();
 
 protected:
@@ -58,4 +76,35 @@ private:
 };
 
 
+template<typename Work>
+void ThreadPool::parallelFor(const unsigned int first, 
+                             const unsigned int count, 
+                             const unsigned int chunkSize, 
+                             Work work, 
+                             const unsigned int priority) {
+  const unsigned int numberOfChunks = (count + chunkSize - 1) / chunkSize;
+
+  if( numberOfChunks <= 1 ) {
+    if( count > 0 ) {
+      work(0, first, count);
+    }
+    return;
+  }
+
+  std::atomic<unsigned int> pendingChunks{numberOfChunks};
+
+  for(unsigned int chunk=0; chunk<numberOfChunks; chunk++) {
+    const unsigned int chunkFirst = first + chunk * chunkSize;
+    const unsigned int chunkCount = std::min(chunkSize, first + count - chunkFirst);
+    std::atomic<unsigned int>* pending = &pendingChunks;
+    add(new WorkItem([work, chunk, chunkFirst, chunkCount, pending]() {
+      work(chunk, chunkFirst, chunkCount);
+      pending->fetch_sub(1);
+    }, priority));
+  }
+
+  wait(pendingChunks, priority);
+}
+
+
 #endif // THREADPOOL_H
\ No newline at end of file
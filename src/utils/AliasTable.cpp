@@ -0,0 +1,69 @@
+#include "AliasTable.h"
+
+
+AliasTable::AliasTable(const std::vector<float>& weights)
+: thresholds_(weights.size(), 1.0f)
+, aliases_(weights.size())
+, probabilities_(weights.size())
+{
+  double sum = 0.0;
+  for(const float weight : weights) {
+    if( weight < 0.0f ) {
+      throw std::invalid_argument{"Alias table weights must not be negative."};
+    }
+    sum += weight;
+  }
+
+  if( !(sum > 0.0) ) {
+    throw std::invalid_argument{"Alias table needs a positive weight."};
+  }
+
+  // Scaled so that the mean entry is exactly full, then Vose's pairing of 
+  // an underfull entry with an overfull one until all are full
+  std::vector<double> scaled(weights.size());
+  std::vector<unsigned int> small;
+  std::vector<unsigned int> large;
+
+  for(unsigned int i=0; i<weights.size(); i++) {
+    probabilities_[i] = weights[i] / sum;
+    scaled[i] = weights[i] * weights.size() / sum;
+    aliases_[i] = i;
+    if( scaled[i] < 1.0 ) {
+      small.push_back(i);
+    } else {
+      large.push_back(i);
+    }
+  }
+
+  while( !small.empty() && !large.empty() ) {
+    const unsigned int less = small.back();
+    small.pop_back();
+    const unsigned int more = large.back();
+
+    thresholds_[less] = scaled[less];
+    aliases_[less] = more;
+
+    scaled[more] -= 1.0 - scaled[less];
+    if( scaled[more] < 1.0 ) {
+      large.pop_back();
+      small.push_back(more);
+    }
+  }
+
+  // What is left is full up to rounding and keeps its threshold of one. Entries 
+  // without weight must never be kept though, they take the heaviest entry instead.
+  const unsigned int heaviest = std::max_element(weights.begin(), weights.end()) - weights.begin();
+  for(const unsigned int left : small) {
+    if( weights[left] == 0.0f ) {
+      thresholds_[left] = 0.0f;
+      aliases_[left] = heaviest;
+    }
+  }
+}
+
+
+unsigned int AliasTable::sample(const float u) const {
+  const float scaled = u * thresholds_.size();
+  const unsigned int index = std::min((unsigned int)scaled, (unsigned int)thresholds_.size() - 1);
+  return (scaled - index) < thresholds_[index] ? index : aliases_[index];
+}
@@ -0,0 +1,38 @@
+#ifndef ALIASTABLE_H
+#define ALIASTABLE_H
+
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+
+
+// Walker's alias method, samples index i with probability weights[i] / sum(weights) 
+// in constant time. Every entry of the table is split between its own index and 
+// one alias, so a sample takes a single uniform number and one comparison.
+class AliasTable {
+
+public:
+  AliasTable() = default;
+
+  // Weights must not be negative and at least one must be positive
+  explicit AliasTable(const std::vector<float>& weights);
+
+  // Index drawn with its probability, u is uniform in [0, 1)
+  unsigned int sample(const float u) const;
+
+  float getProbability(const unsigned int index) const { return probabilities_[index]; }
+
+  unsigned int getSize() const { return probabilities_.size(); }
+
+protected:
+
+private:
+  // Chance of keeping the index of an entry instead of taking its alias
+  std::vector<float> thresholds_;
+  std::vector<unsigned int> aliases_;
+  std::vector<float> probabilities_;
+
+};
+
+
+#endif // ALIASTABLE_H
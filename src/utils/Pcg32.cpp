@@ -0,0 +1,166 @@
+#include "Pcg32.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PCG32_SIMD
+#include <immintrin.h>
+#endif
+
+
+const unsigned long long Pcg32::multiplier_;
+
+// Values per block of fill(), lane i of a block is value i after the block start
+static const unsigned int lanes = 8;
+
+
+Pcg32::Pcg32(const unsigned long long seed, const unsigned long long stream)
+: state_{0}
+, increment_{(stream << 1) | 1}
+{
+  next();
+  state_ += seed;
+  next();
+}
+
+
+void Pcg32::advance(const unsigned long long steps) {
+  unsigned long long multiplier;
+  unsigned long long increment;
+  getJump(steps, multiplier, increment);
+  state_ = state_ * multiplier + increment;
+}
+
+
+void Pcg32::getJump(unsigned long long steps, unsigned long long& multiplier, unsigned long long& increment) const {
+  unsigned long long stepMultiplier = multiplier_;
+  unsigned long long stepIncrement = increment_;
+  multiplier = 1;
+  increment = 0;
+
+  // Composes the jumps of the powers of two in steps
+  while( steps > 0 ) {
+    if( steps & 1 ) {
+      multiplier *= stepMultiplier;
+      increment = increment * stepMultiplier + stepIncrement;
+    }
+    stepIncrement = (stepMultiplier + 1) * stepIncrement;
+    stepMultiplier *= stepMultiplier;
+    steps >>= 1;
+  }
+}
+
+
+// Fills blocks of lanes values from lane states that are one value apart,
+// every state then jumps a whole block ahead
+static void fillLanesReference(unsigned long long* states,
+                               const unsigned long long multiplier,
+                               const unsigned long long increment,
+                               float* samples,
+                               const unsigned int blocks) {
+  for(unsigned int block=0; block<blocks; block++) {
+    for(unsigned int lane=0; lane<lanes; lane++) {
+      const unsigned long long state = states[lane];
+      const unsigned int xorShifted = static_cast<unsigned int>(((state >> 18) ^ state) >> 27);
+      const unsigned int rotation = static_cast<unsigned int>(state >> 59);
+      const unsigned int value = (xorShifted >> rotation) | (xorShifted << ((32 - rotation) & 31));
+      samples[block * lanes + lane] = (value >> 8) * (1.0f / 16777216.0f);
+      states[lane] = state * multiplier + increment;
+    }
+  }
+}
+
+
+#ifdef PCG32_SIMD
+
+// 64 bit products modulo 2^64 from the 32 bit multiplies AVX2 has
+__attribute__((target("avx2")))
+static inline __m256i multiply64(const __m256i a, const __m256i bLow, const __m256i bHigh) {
+  const __m256i low = _mm256_mul_epu32(a, bLow);
+  const __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), bLow), _mm256_mul_epu32(a, bHigh));
+  return _mm256_add_epi64(low, _mm256_slli_epi64(cross, 32));
+}
+
+
+// Outputs of four states, in the low 32 bits of each 64 bit lane
+__attribute__((target("avx2")))
+static inline __m256i output(const __m256i state) {
+  const __m256i xorShifted = _mm256_srli_epi64(_mm256_xor_si256(_mm256_srli_epi64(state, 18), state), 27);
+  const __m256i rotation = _mm256_srli_epi64(state, 59);
+  // Shifts by 32 give 0, so a rotation by 0 needs no mask
+  return _mm256_or_si256(_mm256_srlv_epi32(xorShifted, rotation),
+                         _mm256_sllv_epi32(xorShifted, _mm256_sub_epi32(_mm256_set1_epi32(32), rotation)));
+}
+
+
+__attribute__((target("avx2")))
+static void fillLanesAvx(unsigned long long* states,
+                         const unsigned long long multiplier,
+                         const unsigned long long increment,
+                         float* samples,
+                         const unsigned int blocks) {
+  const __m256i multiplierLow = _mm256_set1_epi64x(static_cast<long long>(multiplier & 0xffffffffULL));
+  const __m256i multiplierHigh = _mm256_set1_epi64x(static_cast<long long>(multiplier >> 32));
+  const __m256i increments = _mm256_set1_epi64x(static_cast<long long>(increment));
+  const __m256i evenFirst = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+  const __m256 scale = _mm256_set1_ps(1.0f / 16777216.0f);
+
+  __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(states));
+  __m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(states + 4));
+
+  for(unsigned int block=0; block<blocks; block++) {
+    const __m256i firstValues = _mm256_permutevar8x32_epi32(output(first), evenFirst);
+    const __m256i secondValues = _mm256_permutevar8x32_epi32(output(second), evenFirst);
+    const __m256i values = _mm256_permute2x128_si256(firstValues, secondValues, 0x20);
+
+    _mm256_storeu_ps(samples + block * lanes, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(values, 8)), scale));
+
+    first = _mm256_add_epi64(multiply64(first, multiplierLow, multiplierHigh), increments);
+    second = _mm256_add_epi64(multiply64(second, multiplierLow, multiplierHigh), increments);
+  }
+
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(states), first);
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(states + 4), second);
+}
+
+
+typedef void (*LaneFiller)(unsigned long long*, const unsigned long long, const unsigned long long, float*, const unsigned int);
+
+static LaneFiller selectLaneFiller() {
+  __builtin_cpu_init();
+  if( __builtin_cpu_supports("avx2") ) {
+    return fillLanesAvx;
+  }
+  return fillLanesReference;
+}
+
+#endif
+
+
+void Pcg32::fill(float* samples, const unsigned int count) {
+  const unsigned int blocks = count / lanes;
+
+  if( blocks > 0 ) {
+    unsigned long long states[lanes];
+    for(unsigned int lane=0; lane<lanes; lane++) {
+      states[lane] = state_;
+      next();
+    }
+
+    unsigned long long multiplier;
+    unsigned long long increment;
+    getJump(lanes, multiplier, increment);
+
+#ifdef PCG32_SIMD
+    static const LaneFiller fillLanes = selectLaneFiller();
+    fillLanes(states, multiplier, increment, samples, blocks);
+#else
+    fillLanesReference(states, multiplier, increment, samples, blocks);
+#endif
+
+    // The first lane has moved on by all values of the blocks
+    state_ = states[0];
+  }
+
+  for(unsigned int i=blocks * lanes; i<count; i++) {
+    samples[i] = next0To1();
+  }
+}
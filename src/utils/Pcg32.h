@@ -0,0 +1,45 @@
+#ifndef PCG32_H
+#define PCG32_H
+
+
+// O'Neill's PCG32 (XSH RR): a 64 bit linear congruential state with a permuted
+// 32 bit output. Draws the random scenes of tests and benchmarks, generators
+// with different streams give independent sequences from the same seed.
+class Pcg32 {
+
+public:
+  explicit Pcg32(const unsigned long long seed = 0x853c49e6748fea9bULL, const unsigned long long stream = 0);
+
+  unsigned int next() {
+    const unsigned long long state = state_;
+    state_ = state * multiplier_ + increment_;
+    const unsigned int xorShifted = static_cast<unsigned int>(((state >> 18) ^ state) >> 27);
+    const unsigned int rotation = static_cast<unsigned int>(state >> 59);
+    return (xorShifted >> rotation) | (xorShifted << ((32 - rotation) & 31));
+  }
+
+  // Uniform in [0, 1), the top 24 bits of next() so that every value is exact
+  float next0To1() { return (next() >> 8) * (1.0f / 16777216.0f); }
+
+  // The next count values of next0To1(), in order. Eight at a time with AVX2
+  // when the CPU supports it, the generator ends up where count calls would leave it.
+  void fill(float* samples, const unsigned int count);
+
+  // Skips steps values in logarithmic time
+  void advance(const unsigned long long steps);
+
+protected:
+
+private:
+  static const unsigned long long multiplier_ = 6364136223846793005ULL;
+
+  unsigned long long state_;
+  unsigned long long increment_;
+
+  // Multiplier and increment that advance the state by steps values at once
+  void getJump(unsigned long long steps, unsigned long long& multiplier, unsigned long long& increment) const;
+
+};
+
+
+#endif // PCG32_H
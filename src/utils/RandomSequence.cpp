@@ -0,0 +1,11 @@
+#include "RandomSequence.h"
+
+
+RandomSequence::RandomSequence(const Sampler* sampler, const unsigned int pixel, const unsigned int sample)
+: sampler_{sampler}
+, pixel_{pixel}
+, sample_{sample}
+, dimension_{0}
+{
+
+}
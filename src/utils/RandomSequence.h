@@ -0,0 +1,46 @@
+#ifndef RANDOMSEQUENCE_H
+#define RANDOMSEQUENCE_H
+
+#include "glm/glm.hpp"
+
+#include "samplers/Sampler.h"
+
+
+// The random numbers of one camera path: sample of pixel taken from sampler, one
+// dimension after the other. The integrator moves to fixed dimensions at every bounce,
+// so a path draws the same values whichever thread, tile order or process renders it.
+class RandomSequence {
+
+public:
+  RandomSequence() = default;
+
+  RandomSequence(const Sampler* sampler, const unsigned int pixel, const unsigned int sample);
+
+  // Uniform in [0, 1), the next dimension of the path
+  float next0To1() { return sampler_->get1D(pixel_, sample_, dimension_++); }
+
+  // Uniform in [0, 1)^2, the next dimension of the path
+  glm::vec2 next2D() { return sampler_->get2D(pixel_, sample_, dimension_++); }
+
+  // next0To1() of the next count dimensions of the path, drawn in one batch
+  void next0To1(float* values, const unsigned int count) {
+    sampler_->fill1D(pixel_, sample_, dimension_, count, values);
+    dimension_ += count;
+  }
+
+  void setDimension(const unsigned int dimension) { dimension_ = dimension; }
+
+  unsigned int getDimension() const { return dimension_; }
+
+protected:
+
+private:
+  const Sampler* sampler_;
+  unsigned int pixel_;
+  unsigned int sample_;
+  unsigned int dimension_;
+
+};
+
+
+#endif // RANDOMSEQUENCE_H
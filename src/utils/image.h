@@ -3,6 +3,8 @@
 
 #include <vector>
 #include <stdexcept>
+#include <cmath>
+#include <algorithm>
 
 #include "utils/lodepng.h"
 
@@ -20,6 +22,46 @@ inline void outputImage(const std::string& file,
 }
 
 
+// Tone maps color into pixel (x, y) of the RGBA image
+inline void writePixel(std::vector<unsigned char>& image, const unsigned int width, const unsigned int x, const unsigned int y, const glm::vec3& color) {
+  image[4 * width * y + 4 * x + 0] = std::min( (int)(std::sqrt(color.r) * 100), 255);
+  image[4 * width * y + 4 * x + 1] = std::min( (int)(std::sqrt(color.g) * 100), 255);
+  image[4 * width * y + 4 * x + 2] = std::min( (int)(std::sqrt(color.b) * 100), 255);
+  image[4 * width * y + 4 * x + 3] = 255;
+}
+
+
+inline std::vector<unsigned char> loadImage(const std::string& file,
+                                            unsigned int& width,
+                                            unsigned int& height) {
+  std::vector<unsigned char> image;
+  unsigned error = lodepng::decode(image, width, height, file.c_str());
+  if( error ) {
+    throw std::domain_error{ report_error("Lodepng decoder error " << error << ": "<< lodepng_error_text(error)) };
+  }
+  return image;
+}
+
+
+// Root mean square error of the color channels of two images of the same size, 
+// in units of the largest channel value
+inline double computeRmse(const std::vector<unsigned char>& image, const std::vector<unsigned char>& reference) {
+  if( image.size() != reference.size() ) {
+    throw std::invalid_argument{"The image and the reference differ in size"};
+  }
+  double squaredErrors = 0.0;
+  unsigned int channels = 0;
+  for(unsigned int i=0; i<image.size(); i++) {
+    if( i % 4 != 3 ) {
+      const double error = (image[i] - reference[i]) / 255.0;
+      squaredErrors += error * error;
+      channels++;
+    }
+  }
+  return std::sqrt(squaredErrors / std::max(1u, channels));
+}
+
+
 inline glm::vec3 checker(const glm::vec3& uv, const glm::vec3& color0, const glm::vec3& color1) {
   if( (int(floor(uv.x) + floor(uv.y) + floor(uv.z)) & 1 ) == 0) {
     return color0;
@@ -47,6 +47,43 @@ static float cos2Phi(const Ray& ray) {
   return cosPhi(ray) * cosPhi(ray);
 }
 
+// Share of unpolarized light reflected by a dielectric boundary, cosIncident is the cosine 
+// between the incident direction and the normal and eta the refraction index of the side 
+// the light comes from over the one it enters. 1 for total internal reflection.
+inline float fresnelDielectric(const float cosIncident, const float eta) {
+  const float sin2Transmitted = eta * eta * std::max(0.0f, 1.0f - cosIncident * cosIncident);
+  if( sin2Transmitted >= 1.0f ) {
+    return 1.0f;
+  }
+  const float cosTransmitted = std::sqrt(1.0f - sin2Transmitted);
+  const float perpendicular = (eta * cosIncident - cosTransmitted) / (eta * cosIncident + cosTransmitted);
+  const float parallel = (cosIncident - eta * cosTransmitted) / (cosIncident + eta * cosTransmitted);
+  return 0.5f * (perpendicular * perpendicular + parallel * parallel);
+}
+
+// Orthonormal basis with normal as its z axis, for moving directions between the world 
+// and the local shading frame. Built without branches or trigonometry following 
+// Duff et al., "Building an Orthonormal Basis, Revisited".
+struct Frame {
+  explicit Frame(const glm::vec3& n)
+  : normal{n}
+  {
+    const float sign = std::copysign(1.0f, n.z);
+    const float a = -1.0f / (sign + n.z);
+    const float b = n.x * n.y * a;
+    tangent = glm::vec3{1.0f + sign * n.x * n.x * a, sign * b, -sign * n.x};
+    bitangent = glm::vec3{b, sign + n.y * n.y * a, -n.y};
+  }
+
+  glm::vec3 toLocal(const glm::vec3& v) const { return glm::vec3{glm::dot(v, tangent), glm::dot(v, bitangent), glm::dot(v, normal)}; }
+
+  glm::vec3 toWorld(const glm::vec3& v) const { return v.x * tangent + v.y * bitangent + v.z * normal; }
+
+  glm::vec3 tangent;
+  glm::vec3 bitangent;
+  glm::vec3 normal;
+};
+
 inline glm::mat3 computeRotationMatrix(const glm::vec3& normal) {
   // static std::default_random_engine generator;
   // static std::default_random_engine generator2;
@@ -8,42 +8,15 @@
 
 #include "exception/Error.h"
 
-#include "glm/glm.hpp"
-
-inline float random0To1() {
-  static std::default_random_engine generator;
-  static std::uniform_real_distribution<float> unifrom0To1Distribution(0.0f, 1.0f);
-  return unifrom0To1Distribution(generator);
-}
-
-inline glm::vec2 getRandomAngles() {
-  const float r1 = random0To1();
-  const float r2 = random0To1();
-
-  // std::cout << "R1: " << r1 << std::endl;
-  // std::cout << "R2: " << r2 << std::endl;
-
-  const float inc = std::acos(std::sqrt(r2));
-  const float horizontal = 2.0f * M_PI * r1;
+#include "RandomSequence.h"
 
-  // std::cout << "horizontal: " << horizontal << std::endl;
-  // std::cout << "inc: " << inc << std::endl;
-
-
-  // if( !((horizontal >= 0.0f) && (horizontal <= (2.0f * M_PI))) ) {
-  //   throw std::invalid_argument{ report_error("horizontal angle not correct: " << horizontal << " " << inc) };
-  // }
-
-  // if( !((inc >= 0.0f) && (inc <= (M_PI / 2.0f))) ) {
-  //   throw std::invalid_argument{ report_error("inclination angle not correct: " << horizontal << " " << inc) };
-  // }
-
-  return glm::vec2(inc, horizontal);
-}
+#include "glm/glm.hpp"
 
-inline glm::vec3 getRandomVector() {
-  const float r1 = random0To1();
-  const float r2 = random0To1();
+// Cosine weighted direction around the z axis of the local shading frame, 
+// its probability density is z / pi, u uniform in [0, 1)^2
+inline glm::vec3 getRandomVector(const glm::vec2& u) {
+  const float r1 = u.x;
+  const float r2 = u.y;
 
   const float r = std::sqrt(r1);
   const float theta = 2.0f * M_PI * r2;
@@ -54,10 +27,13 @@ inline glm::vec3 getRandomVector() {
   return glm::vec3{x, y, std::sqrt(std::max(0.0f, 1.0f - r1))};
 }
 
-inline bool shouldTerminateRay(const float phi, const float probabilityNotToTerminateRay) {
-  return (phi / probabilityNotToTerminateRay) > (2.0f * M_PI);
-  // return phi > (2.0f * M_PI * probabilityNotToTerminateRay) ;
+// Direction distributed uniformly over the unit sphere, u uniform in [0, 1)^2
+inline glm::vec3 getRandomSphereVector(const glm::vec2& u) {
+  const float z = 1.0f - 2.0f * u.x;
+  const float r = std::sqrt(std::max(0.0f, 1.0f - z * z));
+  const float phi = 2.0f * M_PI * u.y;
 
+  return glm::vec3{r * std::cos(phi), r * std::sin(phi), z};
 }
 
 